@@ -0,0 +1,169 @@
+// This document contains an implementation of a batched binary search, which
+// answers many queries at once, along with a benchmark comparing it to
+// calling the recursive binary search in binary-search.cpp once per query.
+
+// When we search a big array one key at a time, almost every step of the
+// search is a cache miss, and the CPU can't do anything useful while it waits
+// for memory, because the next step depends on the element it's waiting for.
+// But the steps of two DIFFERENT searches don't depend on each other at all.
+// So if we have a whole batch of keys to look up, we can advance a group of
+// searches in lockstep: do one step of search 1, then one step of search 2,
+// and so on, before coming back to search 1. The CPU can then have many cache
+// misses in flight at the same time (this is called memory-level parallelism),
+// and we also prefetch the element each search will need on its next step.
+// This technique is called group prefetching.
+
+// To make the lockstep easy, every search in the group uses the branchless
+// lower bound from branchless-binary-search.cpp. Since the number of steps of
+// a branchless search only depends on the size of the array, all the searches
+// in a group finish at the same time.
+
+// Each query still takes O(log(n)) time, so a batch of q queries takes
+// O(q * log(n)) time, but the waits for memory overlap with each other.
+
+#include "headers/binary-search.h" // the original recursive binary search to compare against
+#include <chrono>   // for timing the benchmark
+#include <cstdlib>  // for atol
+#include <iostream> // basic input and output
+#include <vector>   // to be able to use vectors
+
+// the number of searches advanced together. This should be around the number
+// of cache misses the CPU can have in flight at the same time
+const int GROUP_SIZE = 16;
+
+// this function will take a pointer to a sorted int array, an interval start
+// and an interval end (just like binarySearch), as well as an array of n keys
+// to search for and an output array of size n. For every key, it stores the
+// location of the key in the output array, or -1 if the key isn't found. If a
+// key occurs more than once in the array, the first occurence is returned
+void binarySearchBatch(int *arr, int start, int end, const int *keys, int n,
+                       int *out) {
+  // the strategy is to split the keys into groups of GROUP_SIZE. For each
+  // group, keep a base pointer per search, and advance all of them by one step
+  // at a time (see branchless-binary-search.cpp for how one step works). Right
+  // after each step, prefetch the middle element of the search's new interval
+  // so it's ready by the time we come back to it
+
+  int size = end - start + 1; // the number of elements in the interval
+  const int *base[GROUP_SIZE]; // the base pointer of every search in the group
+
+  for (int g = 0; g < n; g += GROUP_SIZE) {
+    int count = n - g < GROUP_SIZE ? n - g : GROUP_SIZE; // searches in group
+    const int *group = keys + g; // the keys of this group
+
+    // if there is nothing to search, none of the keys can be found
+    if (size <= 0) {
+      for (int i = 0; i < count; i++)
+        out[g + i] = -1;
+      continue;
+    }
+
+    // every search starts with the whole interval
+    for (int i = 0; i < count; i++)
+      base[i] = arr + start;
+
+    int len = size; // the length of the current interval (same for all)
+
+    while (len > 1) {
+      int half = len / 2;
+
+      // advance every search in the group by one step, and prefetch the
+      // element it will compare against on its next step
+      for (int i = 0; i < count; i++) {
+        base[i] = (base[i][half] < group[i]) ? base[i] + half : base[i];
+        __builtin_prefetch(base[i] + (len - half) / 2);
+      }
+
+      len -= half;
+    }
+
+    // finish the searches: the lower bound is either the last element left or
+    // the one right after it, and the key is found only if it's equal to it
+    for (int i = 0; i < count; i++) {
+      int pos = (base[i] - arr) + (*base[i] < group[i]);
+      out[g + i] = (pos <= end && arr[pos] == group[i]) ? pos : -1;
+    }
+  }
+}
+
+// main function, which is just driver code to test and benchmark the above
+int main(int argc, char *argv[]) {
+  int array[] = {2, 3, 4, 10, 40}; // a static array to test the function on
+  int size = sizeof(array) / sizeof(array[0]); // finding the size of the array
+
+  int keys[] = {10, 12, 2, 40, 41, 0}; // the batch of keys to search for
+  int numKeys = sizeof(keys) / sizeof(keys[0]);
+  int results[sizeof(keys) / sizeof(keys[0])];
+
+  binarySearchBatch(array, 0, size - 1, keys, numKeys, results);
+
+  for (int i = 0; i < numKeys; i++) {
+    // make sure the batched search agrees with the recursive one
+    if (results[i] != binarySearch(array, 0, size - 1, keys[i])) {
+      std::cout << "Mismatch when searching for " << keys[i] << std::endl;
+      return 1;
+    }
+
+    (results[i] != -1)
+        ? std::cout << "Element " << keys[i]
+                    << " found at index: " << results[i] << std::endl
+        : std::cout << "Element " << keys[i] << " not found in array."
+                    << std::endl;
+  }
+
+  // BENCHMARK
+  // we search arrays of 1K, 1M and 100M even numbers with a batch of random
+  // queries, so about half of the searches are hits and half are misses
+  long maxSize = argc > 1 ? std::atol(argv[1]) : 100000000;
+  long sizes[] = {1000, 1000000, 100000000};
+  const int numQueries = 1000000;
+
+  std::cout << "size\trecursive (ns)\tbatched (ns)" << std::endl;
+
+  for (long n : sizes) {
+    if (n > maxSize)
+      break;
+
+    std::vector<int> arr(n);
+    for (long i = 0; i < n; i++)
+      arr[i] = 2 * i;
+
+    // generate the queries with a simple xorshift random number generator
+    std::vector<int> queries(numQueries);
+    unsigned long long seed = 88172645463325252ULL;
+    for (int &q : queries) {
+      seed ^= seed << 13;
+      seed ^= seed >> 7;
+      seed ^= seed << 17;
+      q = seed % (2 * n);
+    }
+
+    std::vector<int> expected(numQueries), batched(numQueries);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < numQueries; i++)
+      expected[i] = binarySearch(arr.data(), 0, n - 1, queries[i]);
+    auto middle = std::chrono::steady_clock::now();
+    binarySearchBatch(arr.data(), 0, n - 1, queries.data(), numQueries,
+                      batched.data());
+    auto finish = std::chrono::steady_clock::now();
+
+    // since all the keys are distinct, both searches must agree exactly
+    if (expected != batched) {
+      std::cout << "Results differ for size " << n << std::endl;
+      return 1;
+    }
+
+    std::cout << n << "\t"
+              << std::chrono::duration<double, std::nano>(middle - begin)
+                         .count() /
+                     numQueries
+              << "\t\t"
+              << std::chrono::duration<double, std::nano>(finish - middle)
+                         .count() /
+                     numQueries
+              << std::endl;
+  }
+
+  return 0;
+}
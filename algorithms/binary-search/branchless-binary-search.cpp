@@ -0,0 +1,170 @@
+// This document contains an implementation of a branchless, prefetching
+// variant of the binary search algorithm, along with a benchmark comparing it
+// to the recursive implementation in binary-search.cpp.
+
+// The recursive binary search compares the value with the middle element and
+// then takes one of three branches (found, go left, go right). When the
+// lookups are random, the CPU cannot guess which branch will be taken, so it
+// mispredicts about half the time and throws away the work it did
+// speculatively. On arrays that are bigger than the cache, every level after
+// the first few is also a cache miss that the CPU has to wait for.
+
+// the branchless version fixes both of these problems with three changes:
+//    1. instead of returning as soon as we find the value, we always compute
+//    the lower bound (the first position whose element is not less than the
+//    value). That means there is no "found" branch inside the loop, and the
+//    number of iterations only depends on the size of the array.
+//    2. the "go left or go right" decision is written as a conditional move
+//    (base = cond ? base + half : base), which the compiler turns into a cmov
+//    instruction instead of a jump, so there is nothing to mispredict.
+//    3. since we don't know which half we will pick next, we prefetch the
+//    middle elements of BOTH possible halves. One of the two prefetches is
+//    wasted, but the other one means the next comparison is (hopefully)
+//    already in the cache by the time we need it.
+
+// The time complexity is still O(log(n)), but every search does exactly
+// ceil(log2(n)) iterations with no unpredictable branches.
+
+// compile with optimizations on (e.g. g++ -O2) so the conditional move is
+// actually emitted. The benchmark sizes can be limited by passing the largest
+// size to run as the first argument (default is 100M elements).
+
+#include "headers/binary-search.h" // the original recursive binary search to compare against
+#include <chrono>   // for timing the benchmark
+#include <cstdlib>  // for atol
+#include <iostream> // basic input and output
+#include <vector>   // to be able to use vectors
+
+// this function will take a pointer to a sorted int array, the number of
+// elements in the array and a value to search for. It returns the lower bound
+// of the value, which is the index of the first element that is not less than
+// the value (or n, if every element is less than the value)
+int branchlessLowerBound(const int *arr, int n, int val) {
+  // the strategy is to keep a base pointer and a length. At every step we
+  // look at the element in the middle of the current interval. If it is less
+  // than the value, the lower bound must be in the upper half, so we move the
+  // base up by half. Either way the length of the interval is halved. When
+  // only one element is left, the lower bound is either that element or the
+  // one right after it.
+
+  // if there is nothing to search, the lower bound is the start of the array
+  if (n <= 0)
+    return 0;
+
+  const int *base = arr; // the start of the current interval
+  int len = n;           // the length of the current interval
+
+  while (len > 1) {
+    int half = len / 2; // the size of the half we might skip over
+
+    // prefetch the middle elements of both possible next intervals. If we
+    // don't move the base, the next interval is [base, base + len - half),
+    // otherwise it's [base + half, base + len)
+    __builtin_prefetch(base + (len - half) / 2);
+    __builtin_prefetch(base + half + (len - half) / 2);
+
+    // move the base up if the middle element is less than the value. This is
+    // written as a ternary so the compiler emits a conditional move
+    base = (base[half] < val) ? base + half : base;
+    len -= half; // the interval always shrinks by half
+  }
+
+  // the only element left is either the lower bound, or it's less than the
+  // value (in which case the lower bound is the element right after it)
+  return (base - arr) + (*base < val);
+}
+
+// this function has the same signature and return value as the recursive
+// binarySearch: it takes a pointer to an int array, an interval start, an
+// interval end and a value to search for. If the value is found, it returns
+// the location of the element. Else it returns -1. If the value occurs more
+// than once, this always returns the first occurence
+int branchlessBinarySearch(int *arr, int start, int end, int val) {
+  // find the lower bound in the interval [start, end]
+  int i = start + branchlessLowerBound(arr + start, end - start + 1, val);
+
+  // the value was found only if the lower bound is inside the interval and
+  // the element there is equal to the value
+  return (i <= end && arr[i] == val) ? i : -1;
+}
+
+// this is a utility function that will run the given search function on every
+// query and return the number of nanoseconds each search took on average. It
+// also adds the results into a checksum so the compiler can't skip the work
+template <typename Search>
+double timeSearches(Search search, std::vector<int> &arr,
+                    std::vector<int> &queries, long long &checksum) {
+  auto begin = std::chrono::steady_clock::now();
+
+  for (int q : queries)
+    checksum += search(arr.data(), 0, (int)arr.size() - 1, q);
+
+  auto finish = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::nano>(finish - begin).count() /
+         queries.size();
+}
+
+// main function, which is just driver code to test and benchmark the above
+int main(int argc, char *argv[]) {
+  int array[] = {2, 3, 4, 10, 40}; // a static array to test the function on
+  int size = sizeof(array) / sizeof(array[0]); // finding the size of the array
+
+  // make sure the branchless version gives the same answers as the recursive
+  // one for every value around the ones in the array
+  for (int val = 0; val <= 41; val++) {
+    if (binarySearch(array, 0, size - 1, val) !=
+        branchlessBinarySearch(array, 0, size - 1, val)) {
+      std::cout << "Mismatch when searching for " << val << std::endl;
+      return 1;
+    }
+  }
+
+  int result = branchlessBinarySearch(array, 0, size - 1, 10);
+  std::cout << "Element " << 10 << " found at index: " << result << std::endl;
+
+  // BENCHMARK
+  // we search arrays of 1K, 1M and 100M elements. The array holds the even
+  // numbers, and the queries are random numbers in the same range, so about
+  // half of the searches are hits and half are misses
+  long maxSize = argc > 1 ? std::atol(argv[1]) : 100000000;
+  long sizes[] = {1000, 1000000, 100000000};
+  const int numQueries = 1000000;
+
+  std::cout << "size\trecursive (ns)\tbranchless (ns)" << std::endl;
+
+  for (long n : sizes) {
+    if (n > maxSize)
+      break;
+
+    std::vector<int> arr(n);
+    for (long i = 0; i < n; i++)
+      arr[i] = 2 * i;
+
+    // generate the queries with a simple xorshift random number generator
+    std::vector<int> queries(numQueries);
+    unsigned long long seed = 88172645463325252ULL;
+    for (int &q : queries) {
+      seed ^= seed << 13;
+      seed ^= seed >> 7;
+      seed ^= seed << 17;
+      q = seed % (2 * n);
+    }
+
+    long long recursiveSum = 0, branchlessSum = 0;
+    double recursive =
+        timeSearches(binarySearch, arr, queries, recursiveSum);
+    double branchless =
+        timeSearches(branchlessBinarySearch, arr, queries, branchlessSum);
+
+    // since all the keys are distinct, both versions must agree exactly
+    if (recursiveSum != branchlessSum) {
+      std::cout << "Results differ for size " << n << std::endl;
+      return 1;
+    }
+
+    std::cout << n << "\t" << recursive << "\t\t" << branchless << std::endl;
+  }
+
+  return 0;
+}
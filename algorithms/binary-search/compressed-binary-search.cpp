@@ -0,0 +1,331 @@
+// This document contains an implementation of a compressed sorted array that
+// can be searched without decompressing all of it, along with a benchmark
+// comparing its size and speed to the recursive binary search in
+// binary-search.cpp over a plain int array.
+
+// When an array is much bigger than the cache, binary search spends most of
+// its time waiting for memory. One way to wait less is to make the array
+// smaller. In a sorted array, the difference between neighbouring keys (the
+// delta) is usually much smaller than the keys themselves, so it takes fewer
+// bits to store. So we split the array into blocks of 128 keys, and for every
+// block we store:
+//    - the first key of the block (the head), uncompressed, in a separate array
+//    of heads
+//    - the deltas of the other keys, using only as many bits per delta as the
+//    biggest delta in the block needs (this is called bit packing)
+
+// To search, we binary search the (small) array of heads to find the one block
+// that can contain the value, and only decompress that block.
+
+// To make decompressing fast, the deltas are laid out for SIMD: a register
+// holds 8 ints, so each delta is the difference between a key and the key 8
+// positions before it (not the one right before it). That way, after we unpack
+// 8 deltas into a register, adding the previous 8 keys gives us the next 8
+// keys in one instruction. The bits are also packed "vertically": lane l of
+// every packed word only holds bits of the keys at positions l, l + 8,
+// l + 16, ... so unpacking 8 deltas is just a couple of shifts and a mask on a
+// whole register. As we decode each group of 8 keys, we compare them with the
+// value and stop as soon as we pass it.
+
+// Building the array takes O(n) time, and a search takes O(log(n / 128))
+// time to find the block, plus at most 16 SIMD steps to decode and scan it.
+
+// compile with g++ -O2 -mavx2 (or -march=native) to use the SIMD decoding.
+// The benchmark sizes can be limited by passing the largest size to run as the
+// first argument (default is 100M elements).
+
+#include "headers/binary-search.h" // the original recursive binary search to compare against
+#include <algorithm> // for lower_bound
+#include <chrono>    // for timing the benchmark
+#include <cstdint>   // for uint8_t and uint32_t
+#include <cstdlib>   // for atol
+#include <iostream>  // basic input and output
+#include <vector>    // to be able to use vectors
+
+#ifdef __AVX2__
+#include <immintrin.h> // for the AVX2 intrinsics
+#endif
+
+// this class represents the compressed sorted array. It contains a constructor
+// that compresses a sorted array, functions to find the lower bound of a value
+// and search for a value, and a function to get the size of the compressed
+// array in bytes
+class CompressedSortedArray {
+private:
+  static constexpr int BLOCK = 128; // the number of keys in a block
+  static constexpr int LANES = 8;   // the number of keys decoded at once
+
+  int n;                        // the number of keys
+  std::vector<int> heads;       // the first key of every block
+  std::vector<uint8_t> widths;  // the number of bits per delta in every block
+  std::vector<uint32_t> starts; // where every block's packed words start
+  std::vector<uint32_t> words;  // the packed deltas of every block
+
+  // this function will take a block and a value, and return the number of keys
+  // in the block that are less than the value. It also sets found to true if
+  // the first key that is not less than the value is equal to it
+  int scanBlock(int block, int val, bool &found) {
+    // the strategy is to decode the block 8 keys at a time. Group j holds the
+    // keys at positions 8j to 8j + 7, and its delta for lane l starts at bit
+    // j * width of lane l's packed bits. We add the deltas to the previous
+    // group to get the keys, count the keys that are less than the value, and
+    // stop at the first group that has a key that isn't
+
+    int width = this->widths[block];
+    const uint32_t *packed = this->words.data() + this->starts[block];
+    int length = std::min(BLOCK, this->n - block * BLOCK); // keys in block
+    int count = 0;
+    found = false;
+
+#ifdef __AVX2__
+    __m256i keys = _mm256_set1_epi32(this->heads[block]);
+    __m256i target = _mm256_set1_epi32(val);
+    __m256i mask = _mm256_set1_epi32(width == 32 ? -1 : (1u << width) - 1);
+
+    for (int j = 0; j < BLOCK / LANES; j++) {
+      int bit = j * width;
+      int word = bit / 32, shift = bit % 32;
+      __m256i deltas = _mm256_setzero_si256();
+
+      if (width) {
+        // take the bits from the word this delta starts in, and from the next
+        // word too if the delta doesn't fit in the rest of this one
+        __m256i lo =
+            _mm256_loadu_si256((const __m256i *)(packed + word * LANES));
+        deltas = _mm256_srl_epi32(lo, _mm_cvtsi32_si128(shift));
+
+        if (shift + width > 32) {
+          __m256i hi = _mm256_loadu_si256(
+              (const __m256i *)(packed + (word + 1) * LANES));
+          deltas = _mm256_or_si256(
+              deltas, _mm256_sll_epi32(hi, _mm_cvtsi32_si128(32 - shift)));
+        }
+
+        deltas = _mm256_and_si256(deltas, mask);
+      }
+
+      keys = _mm256_add_epi32(keys, deltas); // the next 8 keys
+
+      // count the keys less than the value
+      int less = _mm256_movemask_ps(
+          _mm256_castsi256_ps(_mm256_cmpgt_epi32(target, keys)));
+      int lessCount = __builtin_popcount(less);
+      count += lessCount;
+
+      // if some key isn't less than the value, we've found the lower bound
+      if (lessCount < LANES) {
+        alignas(32) int group[LANES];
+        _mm256_store_si256((__m256i *)group, keys);
+        found = group[lessCount] == val && count < length;
+        return std::min(count, length);
+      }
+    }
+#else
+    // without AVX2, decode every lane of every group one at a time
+    int keys[LANES];
+    for (int l = 0; l < LANES; l++)
+      keys[l] = this->heads[block];
+
+    for (int j = 0; j < BLOCK / LANES; j++) {
+      int bit = j * width;
+      int word = bit / 32, shift = bit % 32;
+      uint32_t mask = width == 32 ? ~0u : (1u << width) - 1;
+      int lessCount = 0;
+
+      for (int l = 0; l < LANES && width; l++) {
+        uint32_t delta = packed[word * LANES + l] >> shift;
+        if (shift + width > 32)
+          delta |= packed[(word + 1) * LANES + l] << (32 - shift);
+        keys[l] = (int)((uint32_t)keys[l] + (delta & mask));
+      }
+
+      for (int l = 0; l < LANES; l++)
+        lessCount += keys[l] < val;
+      count += lessCount;
+
+      if (lessCount < LANES) {
+        found = keys[lessCount] == val && count < length;
+        return std::min(count, length);
+      }
+    }
+#endif
+
+    return length; // every key in the block is less than the value
+  }
+
+public:
+  // constructor that will take a sorted array and its size, and compress it.
+  // The time complexity of this operation is O(n)
+  CompressedSortedArray(const int *sorted, int n) {
+    // the strategy is to go through the array one block at a time. For every
+    // key, compute its delta from the key 8 positions before it (or from the
+    // head, for the first 8 keys). The last block is padded by repeating its
+    // last key. Then find the widest delta in the block and pack all of them
+    // using that many bits each
+
+    this->n = n;
+
+    for (int start = 0; start < n; start += BLOCK) {
+      uint32_t deltas[BLOCK];
+      int head = sorted[start];
+      uint32_t widest = 0;
+
+      for (int i = 0; i < BLOCK; i++) {
+        int key = sorted[std::min(start + i, n - 1)];
+        int previous =
+            i < LANES ? head : sorted[std::min(start + i - LANES, n - 1)];
+        deltas[i] = (uint32_t)key - (uint32_t)previous;
+        widest |= deltas[i];
+      }
+
+      int width = widest ? 32 - __builtin_clz(widest) : 0;
+
+      this->heads.push_back(head);
+      this->widths.push_back(width);
+      this->starts.push_back(this->words.size());
+
+      // every lane holds 16 deltas of width bits each, which take up
+      // (16 * width + 31) / 32 words, and word w of lane l is stored at
+      // w * 8 + l
+      size_t base = this->words.size();
+      int laneWords = (BLOCK / LANES * width + 31) / 32;
+      this->words.resize(base + laneWords * LANES, 0);
+
+      for (int i = 0; i < BLOCK && width; i++) {
+        int lane = i % LANES, j = i / LANES;
+        int bit = j * width;
+        int word = bit / 32, shift = bit % 32;
+
+        this->words[base + word * LANES + lane] |= deltas[i] << shift;
+        if (shift + width > 32)
+          this->words[base + (word + 1) * LANES + lane] |=
+              deltas[i] >> (32 - shift);
+      }
+    }
+
+    // pad the words so that the unaligned 8 word loads in the last block
+    // never read past the end of the vector
+    this->words.resize(this->words.size() + LANES, 0);
+  }
+
+  // this function will take a value and return the position of the first key
+  // that is not less than the value (n if there is none). It also sets found
+  // to true if the key at that position is equal to the value
+  int lowerBound(int val, bool &found) {
+    // find the first block whose head is not less than the value. The answer
+    // is in the block before it, or it's that block's head
+    int block = std::lower_bound(this->heads.begin(), this->heads.end(), val) -
+                this->heads.begin();
+
+    if (block == 0) {
+      found = this->n > 0 && this->heads[0] == val;
+      return 0;
+    }
+
+    int count = scanBlock(block - 1, val, found);
+
+    // if every key in the previous block is less than the value, the answer
+    // is the head of this block
+    if (count == BLOCK && block < (int)this->heads.size())
+      found = this->heads[block] == val;
+
+    return (block - 1) * BLOCK + count;
+  }
+
+  // this function will take a value and return its position in the array if
+  // it is found. Else it returns -1
+  int search(int val) {
+    bool found;
+    int i = lowerBound(val, found);
+    return found ? i : -1;
+  }
+
+  // this function returns the number of bytes used by the compressed array
+  size_t bytes() {
+    return this->heads.size() * sizeof(int) + this->widths.size() +
+           this->starts.size() * sizeof(uint32_t) +
+           this->words.size() * sizeof(uint32_t);
+  }
+};
+
+// main function, which is just driver code to test and benchmark the above
+int main(int argc, char *argv[]) {
+  int array[] = {2, 3, 4, 10, 40}; // a static array to test the function on
+  int size = sizeof(array) / sizeof(array[0]); // finding the size of the array
+
+  CompressedSortedArray compressed(array, size);
+
+  // make sure the compressed array gives the same answers as the recursive
+  // binary search for every value around the ones in the array
+  for (int val = 0; val <= 41; val++) {
+    if (binarySearch(array, 0, size - 1, val) != compressed.search(val)) {
+      std::cout << "Mismatch when searching for " << val << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "Element " << 10 << " found at index: " << compressed.search(10)
+            << std::endl;
+
+  // BENCHMARK
+  // the keys are spread out randomly, about 10 apart from each other, and the
+  // queries are random values in the same range (so many of them are misses)
+  long maxSize = argc > 1 ? std::atol(argv[1]) : 100000000;
+  long sizes[] = {1000, 1000000, 100000000};
+  const int numQueries = 1000000;
+
+  std::cout << "size\tbytes/key\trecursive (ns)\tcompressed (ns)" << std::endl;
+
+  for (long n : sizes) {
+    if (n > maxSize)
+      break;
+
+    // generate the keys and queries with a simple xorshift random number
+    // generator
+    unsigned long long seed = 88172645463325252ULL;
+    auto next = [&seed]() {
+      seed ^= seed << 13;
+      seed ^= seed >> 7;
+      seed ^= seed << 17;
+      return seed;
+    };
+
+    std::vector<int> arr(n);
+    for (long i = 0; i < n; i++)
+      arr[i] = i * 10 + next() % 10;
+
+    std::vector<int> queries(numQueries);
+    for (int &q : queries)
+      q = next() % (n * 10);
+
+    CompressedSortedArray packed(arr.data(), n);
+
+    long long recursiveSum = 0, compressedSum = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int q : queries)
+      recursiveSum += binarySearch(arr.data(), 0, n - 1, q);
+    auto middle = std::chrono::steady_clock::now();
+    for (int q : queries)
+      compressedSum += packed.search(q);
+    auto finish = std::chrono::steady_clock::now();
+
+    // since all the keys are distinct, both searches must agree exactly
+    if (recursiveSum != compressedSum) {
+      std::cout << "Results differ for size " << n << std::endl;
+      return 1;
+    }
+
+    std::cout << n << "\t" << (double)packed.bytes() / n << "\t\t"
+              << std::chrono::duration<double, std::nano>(middle - begin)
+                         .count() /
+                     numQueries
+              << "\t\t"
+              << std::chrono::duration<double, std::nano>(finish - middle)
+                         .count() /
+                     numQueries
+              << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,187 @@
+// This document contains an implementation of the exponential search
+// algorithm, which can search a sorted source without knowing how long it is,
+// along with an append-only sorted log (stored in chunks) to search over.
+
+// Definition of exponential search (Wikipedia): exponential search (also
+// called doubling search, galloping search or Struzik search) is an algorithm
+// for searching sorted, unbounded/infinite lists.
+
+// binarySearch needs to know both ends of the interval before it starts. But
+// if the source keeps growing (like a log that new entries are appended to),
+// or if we expect the value to be near the front, we don't want to look at
+// the whole thing. Exponential search first finds an upper bound: it checks
+// the elements at positions 1, 2, 4, 8, 16, ... until it finds one that is not
+// less than the value (or it runs off the end of the source). The value must
+// then be between the last two positions it checked, so we finish with a
+// binary search over that range.
+
+// If the value is at position i, finding the upper bound takes O(log(i))
+// steps, and the binary search is over a range of size at most i, which also
+// takes O(log(i)) steps. So the whole search takes O(log(i)) time, no matter
+// how long the source is.
+
+// The search functions below work with any source that has a get(i, key)
+// function, which stores the element at position i in key and returns true, or
+// returns false if there is no element at position i (yet).
+
+#include <iostream> // basic input and output
+#include <vector>   // to be able to use vectors
+
+// this class represents an append-only sorted log. The keys are stored in
+// fixed size chunks, so appending never has to copy the keys that are already
+// in the log (unlike a vector, which copies everything when it grows)
+class SortedLog {
+private:
+  static const int CHUNK_BITS = 16;              // log2 of the chunk size
+  static const int CHUNK_SIZE = 1 << CHUNK_BITS; // the keys in a chunk
+
+  std::vector<int *> chunks; // the chunks of keys
+  long length = 0;           // the number of keys in the log
+
+public:
+  SortedLog() = default;
+  ~SortedLog() {
+    for (int *chunk : this->chunks)
+      delete[] chunk;
+  }
+
+  // the log owns its chunks, so copying it would free them twice
+  SortedLog(const SortedLog &) = delete;
+  SortedLog &operator=(const SortedLog &) = delete;
+
+  // this function will take a key and append it to the end of the log. The key
+  // must not be less than the last key in the log, so the log stays sorted
+  void append(int key) {
+    // if the last chunk is full (or there are no chunks), add a new one
+    if (this->length == (long)this->chunks.size() * CHUNK_SIZE)
+      this->chunks.push_back(new int[CHUNK_SIZE]);
+
+    this->chunks.back()[this->length % CHUNK_SIZE] = key;
+    this->length++;
+  }
+
+  // this function will take a position and a reference to a key. If the log
+  // has an element at that position, it is stored in key and this returns
+  // true. Else it returns false
+  bool get(long i, int &key) {
+    if (i >= this->length)
+      return false;
+
+    key = this->chunks[i >> CHUNK_BITS][i & (CHUNK_SIZE - 1)];
+    return true;
+  }
+
+  // this is a utility function that returns the number of keys in the log
+  long size() { return this->length; }
+};
+
+// this function will take a sorted source and a value, and return the position
+// of the first element that is not less than the value. If every element is
+// less than the value, it returns the number of elements in the source
+template <typename Source> long exponentialLowerBound(Source &source, int val) {
+  // the strategy is to check the first element, and if it's less than the
+  // value, keep doubling the position we check until we find an element that
+  // is not less than the value or run off the end. The answer is then after
+  // the second last position we checked, and at or before the last one, so we
+  // binary search between them
+
+  int key; // the element at the position we are checking
+
+  // check the first element
+  if (!source.get(0, key) || key >= val)
+    return 0;
+
+  // double the position until we pass the value or run off the end
+  long bound = 1;
+  while (source.get(bound, key) && key < val)
+    bound *= 2;
+
+  // the element at lo is less than the value, and the element at hi is not (or
+  // hi is past the end), so the answer is in (lo, hi]
+  long lo = bound / 2, hi = bound;
+
+  while (hi - lo > 1) {
+    long mid = lo + (hi - lo) / 2;
+
+    if (source.get(mid, key) && key < val)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  return hi;
+}
+
+// this function will take a sorted source and a value. If the value is found,
+// it returns the location of the element. Else it returns -1
+template <typename Source> long exponentialSearch(Source &source, int val) {
+  long i = exponentialLowerBound(source, val);
+  int key;
+
+  return (source.get(i, key) && key == val) ? i : -1;
+}
+
+// this is a source that wraps another source and counts how many elements the
+// search reads from it, so we can see that the cost only depends on where
+// the value is and not on the size of the source
+template <typename Source> class CountingSource {
+public:
+  Source &source;
+  int reads = 0;
+
+  CountingSource(Source &source) : source(source) {}
+
+  bool get(long i, int &key) {
+    this->reads++;
+    return this->source.get(i, key);
+  }
+};
+
+// main function, which is just driver code to test out the above
+int main() {
+  SortedLog log; // create a new, empty log
+
+  // search the empty log
+  std::cout << "Search for 10 in empty log: " << exponentialSearch(log, 10)
+            << std::endl;
+
+  // append some keys and search for one that is in the log and one that isn't
+  int keys[] = {2, 3, 4, 10, 40};
+  for (int key : keys)
+    log.append(key);
+
+  std::cout << "Element " << 10 << " found at index: "
+            << exponentialSearch(log, 10) << std::endl;
+  std::cout << "Search for 12: " << exponentialSearch(log, 12) << std::endl;
+
+  // keep appending to the log (the even numbers from 42 up), and show that the
+  // number of reads depends on where the value is and not on the log size
+  for (int i = 21; log.size() < 10000000; i++)
+    log.append(2 * i);
+
+  std::cout << "Log now has " << log.size() << " keys" << std::endl;
+  std::cout << "position\treads" << std::endl;
+
+  long positions[] = {4, 100, 10000, 1000000, 9999999};
+  for (long pos : positions) {
+    int key = 0;
+    log.get(pos, key);
+
+    CountingSource<SortedLog> counter(log);
+    long found = exponentialSearch(counter, key);
+
+    if (found != pos) {
+      std::cout << "Expected " << key << " at " << pos << " but got " << found
+                << std::endl;
+      return 1;
+    }
+
+    std::cout << pos << "\t\t" << counter.reads << std::endl;
+  }
+
+  // a value past the end of the log is not found
+  std::cout << "Search for a value past the end: "
+            << exponentialSearch(log, 2000000000) << std::endl;
+
+  return 0;
+}
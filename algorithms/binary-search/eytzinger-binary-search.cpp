@@ -0,0 +1,211 @@
+// This document contains an implementation of binary search over an array
+// stored in the Eytzinger layout (also called BFS order), along with a small
+// benchmark comparing it to the recursive implementation in binary-search.cpp.
+
+// Definition of the Eytzinger layout: the Eytzinger layout stores the elements
+// of a sorted array in the order they would be visited by a breadth-first
+// traversal of the (implicit) binary search tree that binary search walks.
+// Just like a heap, the root is stored at index 1, and the children of the
+// node at index k are stored at indices 2k and 2k + 1.
+
+// When binary search walks a plain sorted array, the first few middle elements
+// are always the same (so they stay in the cache), but every level after that
+// jumps to an unpredictable address far away from the previous one. In the
+// Eytzinger layout, all the nodes of the same level are stored next to each
+// other, and the 16 descendants of a node that are 4 levels below it are
+// stored in one contiguous block of 16 ints (which is exactly one 64 byte
+// cache line). So while we are comparing against the current node, we can
+// prefetch the cache line 4 levels down, and by the time we get there it will
+// already be in the cache.
+
+// The index is built once in O(n) time, and every query runs in O(log(n)) time
+// just like a regular binary search. The search loop is also branchless (the
+// next index is computed with arithmetic instead of an if statement).
+
+// This layout is made for static key sets that are searched a lot: once built,
+// the index can't be modified without rebuilding it.
+
+#include "headers/binary-search.h" // the original recursive binary search to compare against
+#include <chrono>   // for timing the benchmark
+#include <cstdlib>  // for aligned_alloc, free and atol
+#include <iostream> // basic input and output
+#include <vector>   // to be able to use vectors
+
+// this class represents the Eytzinger index. It contains a constructor to build
+// the index from a sorted array, functions to find the lower bound of a value,
+// check if a value is in the index, and a search function which returns the
+// same thing as the recursive binarySearch (so it can replace it)
+class EytzingerIndex {
+private:
+  int *keys;    // the keys in Eytzinger order (1-indexed, keys[0] is unused)
+  int *indices; // the position each key had in the original sorted array
+  int n;        // the number of keys in the index
+
+  // this function will recursively walk the implicit tree in order (left
+  // subtree, node, right subtree) and fill in each node with the next element
+  // of the sorted array. Since an inorder traversal of a binary search tree
+  // visits the nodes in sorted order, this places every element in the right
+  // spot. i is the position of the next element of the sorted array to place
+  void build(const int *sorted, int &i, int k) {
+    if (k <= this->n) {
+      build(sorted, i, 2 * k); // fill in the left subtree
+      this->keys[k] = sorted[i];
+      this->indices[k] = i++;
+      build(sorted, i, 2 * k + 1); // fill in the right subtree
+    }
+  }
+
+  // this function will find the Eytzinger index (the position in the keys
+  // array) of the lower bound of the given value. It returns 0 if every key is
+  // less than the value
+  int lowerBoundNode(int val) {
+    // the strategy is to start at the root and go down the tree: go right if
+    // the current key is less than the value, else go left. Going right means
+    // appending a 1 bit to k and going left means appending a 0 bit. Once we
+    // fall off the tree, the lower bound is the last node where we went left,
+    // which we can find by removing all the trailing 1 bits (the times we went
+    // right) and the last 0 bit (the time we went left)
+
+    int k = 1;
+    while (k <= this->n) {
+      // prefetch the block of 16 descendants 4 levels below the current node
+      // (computed as a size_t, since 16 * k can overflow an int)
+      __builtin_prefetch(this->keys + 16 * (size_t)k);
+      k = 2 * k + (this->keys[k] < val); // go left or right without branching
+    }
+
+    // remove the trailing 1s and the 0 right before them
+    return k >> __builtin_ffs(~k);
+  }
+
+public:
+  // constructor that will take a sorted array and its size, and build the
+  // index from it. The time complexity of this operation is O(n)
+  EytzingerIndex(const int *sorted, int n) {
+    this->n = n;
+
+    // the keys are allocated aligned to a cache line, so that the 16
+    // descendants of every node fall on a single cache line. The size passed to
+    // aligned_alloc has to be a multiple of the alignment
+    size_t bytes = ((n + 1) * sizeof(int) + 63) / 64 * 64;
+    this->keys = (int *)std::aligned_alloc(64, bytes);
+    this->indices = new int[n + 1];
+
+    int i = 0; // the position of the next sorted element to place
+    build(sorted, i, 1);
+  }
+
+  ~EytzingerIndex() {
+    std::free(this->keys);
+    delete[] this->indices;
+  }
+
+  // the index owns its arrays, so copying it would free them twice
+  EytzingerIndex(const EytzingerIndex &) = delete;
+  EytzingerIndex &operator=(const EytzingerIndex &) = delete;
+
+  // this function will take a value and return the index (in the original
+  // sorted array) of the first element that is not less than the value. If
+  // every element is less than the value, it returns n
+  int lowerBound(int val) {
+    int k = lowerBoundNode(val);
+    return k ? this->indices[k] : this->n;
+  }
+
+  // this function will take a value and return true if the value is in the
+  // index, else false
+  bool contains(int val) {
+    int k = lowerBoundNode(val);
+    return k && this->keys[k] == val;
+  }
+
+  // this function will take a value and return its index in the original
+  // sorted array if it is found. Else it returns -1. This is the same thing the
+  // recursive binarySearch returns when searching the whole array
+  int search(int val) {
+    int k = lowerBoundNode(val);
+    return (k && this->keys[k] == val) ? this->indices[k] : -1;
+  }
+};
+
+// main function, which is just driver code to test and benchmark the above
+int main(int argc, char *argv[]) {
+  int array[] = {2, 3, 4, 10, 40}; // a static array to test the index on
+  int size = sizeof(array) / sizeof(array[0]); // finding the size of the array
+
+  EytzingerIndex index(array, size); // build the index from the array
+
+  // make sure the index gives the same answers as the recursive binary search
+  // for every value around the ones in the array
+  for (int val = 0; val <= 41; val++) {
+    if (binarySearch(array, 0, size - 1, val) != index.search(val)) {
+      std::cout << "Mismatch when searching for " << val << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "Element " << 10 << " found at index: " << index.search(10)
+            << std::endl;
+  std::cout << "Lower bound of " << 12 << ": " << index.lowerBound(12)
+            << std::endl;
+  std::cout << "Contains " << 12 << ": " << index.contains(12) << std::endl;
+
+  // BENCHMARK
+  // we search arrays of 1K, 1M and 100M even numbers with random queries, so
+  // about half of the searches are hits and half are misses. The largest size
+  // to run can be passed as the first argument
+  long maxSize = argc > 1 ? std::atol(argv[1]) : 100000000;
+  long sizes[] = {1000, 1000000, 100000000};
+  const int numQueries = 1000000;
+
+  std::cout << "size\trecursive (ns)\teytzinger (ns)" << std::endl;
+
+  for (long n : sizes) {
+    if (n > maxSize)
+      break;
+
+    std::vector<int> arr(n);
+    for (long i = 0; i < n; i++)
+      arr[i] = 2 * i;
+
+    EytzingerIndex eytzinger(arr.data(), n);
+
+    // generate the queries with a simple xorshift random number generator
+    std::vector<int> queries(numQueries);
+    unsigned long long seed = 88172645463325252ULL;
+    for (int &q : queries) {
+      seed ^= seed << 13;
+      seed ^= seed >> 7;
+      seed ^= seed << 17;
+      q = seed % (2 * n);
+    }
+
+    long long recursiveSum = 0, eytzingerSum = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int q : queries)
+      recursiveSum += binarySearch(arr.data(), 0, n - 1, q);
+    auto middle = std::chrono::steady_clock::now();
+    for (int q : queries)
+      eytzingerSum += eytzinger.search(q);
+    auto finish = std::chrono::steady_clock::now();
+
+    // since all the keys are distinct, both searches must agree exactly
+    if (recursiveSum != eytzingerSum) {
+      std::cout << "Results differ for size " << n << std::endl;
+      return 1;
+    }
+
+    std::cout << n << "\t"
+              << std::chrono::duration<double, std::nano>(middle - begin)
+                         .count() /
+                     numQueries
+              << "\t\t"
+              << std::chrono::duration<double, std::nano>(finish - middle)
+                         .count() /
+                     numQueries
+              << std::endl;
+  }
+
+  return 0;
+}
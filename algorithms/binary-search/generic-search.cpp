@@ -0,0 +1,110 @@
+// This document contains driver code for the generic binary search family in
+// headers/generic-search.h, which works on arrays of any type (64 bit keys,
+// doubles, fixed width strings, ...) with any comparator, and uses size_t
+// indices instead of int.
+
+// The original binarySearch only takes an int array and int indices, so it
+// can't search anything but ints, and its indices overflow once the array has
+// more than 2^31 elements. The functions in the header fix both of these
+// problems, and also come in two flavours: a runtime version for arrays of any
+// size, and a compile time version for fixed size arrays of up to 64 elements
+// that is fully unrolled (and can even run while compiling).
+
+#include "headers/generic-search.h" // the generic search family
+#include <algorithm> // for sort and lower_bound (to check the results)
+#include <cstdint>   // for uint64_t
+#include <cstring>   // for strcmp and strncpy
+#include <iostream>  // basic input and output
+#include <random>    // for generating random test arrays
+#include <vector>    // to be able to use vectors
+
+// a fixed width string, like the keys stored in a fixed width record format
+struct FixedString {
+  char data[16];
+};
+
+// a comparator that orders fixed width strings alphabetically
+struct FixedStringLess {
+  bool operator()(const FixedString &a, const FixedString &b) const {
+    return std::strncmp(a.data, b.data, sizeof(a.data)) < 0;
+  }
+};
+
+// a small constant array, which the compile time overloads can search while
+// the program is being compiled
+constexpr int primes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+
+// these checks run at compile time: if any of them were wrong, the program
+// wouldn't compile
+static_assert(lowerBound(primes, 11) == 4, "11 is the fifth prime");
+static_assert(upperBound(primes, 11) == 5, "the upper bound is after 11");
+static_assert(lowerBound(primes, 12) == 5, "12 would go after 11");
+static_assert(contains(primes, 37) && !contains(primes, 38), "37 is prime");
+
+// main function, which is just driver code to test out the generic search
+int main() {
+  // 64 bit keys, with a duplicate, searched with the runtime overloads
+  std::vector<uint64_t> ids = {1ULL << 40, 1ULL << 41, 1ULL << 41, 1ULL << 50};
+  std::pair<size_t, size_t> range =
+      equalRange(ids.data(), ids.size(), (uint64_t)1 << 41);
+  std::cout << "Key 2^41 found at indices: [" << range.first << ", "
+            << range.second << ")" << std::endl;
+
+  // doubles sorted in descending order, searched with a custom comparator
+  double prices[] = {99.5, 42.0, 17.25, 3.0};
+  std::cout << "Lower bound of 20.0 (descending): "
+            << lowerBound(prices, 20.0, std::greater<double>()) << std::endl;
+
+  // fixed width strings
+  std::vector<FixedString> names(3);
+  std::strncpy(names[0].data, "ada", sizeof(names[0].data));
+  std::strncpy(names[1].data, "grace", sizeof(names[1].data));
+  std::strncpy(names[2].data, "linus", sizeof(names[2].data));
+
+  FixedString key = {};
+  std::strncpy(key.data, "grace", sizeof(key.data));
+  std::cout << "Contains \"grace\": "
+            << contains(names.data(), names.size(), key, FixedStringLess())
+            << std::endl;
+
+  // make sure the runtime overloads agree with std::lower_bound and
+  // std::upper_bound on random arrays of every size up to 300 (so both the
+  // linear scan and the halving steps get used)
+  std::mt19937 rng(42);
+  for (size_t n = 0; n <= 300; n++) {
+    std::vector<int> arr(n);
+    for (int &x : arr)
+      x = rng() % 100;
+    std::sort(arr.begin(), arr.end());
+
+    for (int val = -1; val <= 100; val++) {
+      size_t lo = std::lower_bound(arr.begin(), arr.end(), val) - arr.begin();
+      size_t hi = std::upper_bound(arr.begin(), arr.end(), val) - arr.begin();
+
+      if (lowerBound(arr.data(), n, val) != lo ||
+          upperBound(arr.data(), n, val) != hi) {
+        std::cout << "Mismatch for size " << n << " and value " << val
+                  << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  // and make sure the unrolled compile time overloads agree on a 64 element
+  // array with duplicates
+  int fixed[64];
+  for (int i = 0; i < 64; i++)
+    fixed[i] = i / 3;
+
+  for (int val = -1; val <= 22; val++) {
+    if (lowerBound(fixed, val) != lowerBound(fixed, 64, val) ||
+        upperBound(fixed, val) != upperBound(fixed, 64, val)) {
+      std::cout << "Mismatch in the unrolled search for " << val << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "All checks passed" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,21 @@
+#ifndef BINARY_SEARCH_H
+#define BINARY_SEARCH_H
+
+int binarySearch(int *arr, int start, int end, int val) {
+  if (end >= start) {
+    int mid = start + (end - start) / 2;
+
+    if (arr[mid] == val)
+      return mid;
+
+    if (arr[mid] > val)
+      return binarySearch(arr, start, mid - 1, val);
+
+    if (arr[mid] < val)
+      return binarySearch(arr, mid + 1, end, val);
+  }
+
+  return -1;
+}
+
+#endif
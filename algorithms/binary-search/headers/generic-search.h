@@ -0,0 +1,185 @@
+#ifndef GENERIC_SEARCH_H
+#define GENERIC_SEARCH_H
+
+// This header contains a generic, templated family of binary search functions
+// (lowerBound, upperBound, equalRange and contains). They work on arrays of
+// any type with any comparator, and use size_t indices so they can search
+// arrays with more than 2^31 elements. See generic-search.cpp for an example
+// of how to use them.
+
+// Every function takes the comparator as its last argument (std::less by
+// default). comp(a, b) must return true if a should come before b, and the
+// array must be sorted according to comp.
+
+// There are two kinds of overloads:
+//    1. the runtime overloads take a pointer and a size. They halve the
+//    interval with branchless steps until it has at most
+//    LINEAR_SEARCH_THRESHOLD elements left, and then count the elements that
+//    come before the value with a simple loop. The loop has no branches, so
+//    for numbers the compiler turns it into SIMD instructions.
+//    2. the compile time overloads take a reference to a fixed size array.
+//    If the array has at most 64 elements, the halving steps are generated at
+//    compile time (so the whole search is unrolled into straight line code
+//    with no loop at all), and the functions are constexpr, so they can even
+//    be used to search constant arrays while compiling. Bigger arrays just use
+//    the runtime overloads. They only take part in overload resolution when
+//    the last argument really is a comparator, so a runtime call on a fixed
+//    size array, like lowerBound(arr, n, val), still picks the runtime
+//    overload.
+
+#include <cstddef>     // for size_t
+#include <functional>  // for std::less
+#include <type_traits> // for std::enable_if_t and std::is_invocable_r_v
+#include <utility>     // for std::pair
+
+// the size of the interval below which the search switches from halving to a
+// linear scan. Define it before including this header to tune it
+#ifndef LINEAR_SEARCH_THRESHOLD
+#define LINEAR_SEARCH_THRESHOLD 16
+#endif
+
+// this is a comparator that flips the arguments of another comparator and
+// negates the result. So a < b becomes !(b < a), which means a <= b. Running a
+// lower bound with this comparator gives the upper bound
+template <typename Compare> struct NotAfter {
+  Compare comp;
+
+  template <typename A, typename B>
+  constexpr bool operator()(const A &a, const B &b) const {
+    return !comp(b, a);
+  }
+};
+
+// this function will take a pointer to an array, its size, a value and a
+// comparator, and return the number of elements that come before the value.
+// Since the array is sorted, this is also the position of the lower bound
+template <typename T, typename Compare>
+constexpr size_t linearRank(const T *arr, size_t n, const T &val,
+                            Compare comp) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++)
+    count += comp(arr[i], val);
+  return count;
+}
+
+// this function will take a pointer to a sorted array, its size, a value and
+// a comparator, and return the position of the first element that doesn't
+// come before the value (n if there is none)
+template <typename T, typename Compare = std::less<T>>
+size_t lowerBound(const T *arr, size_t n, const T &val,
+                  Compare comp = Compare()) {
+  // the strategy is the same as the branchless binary search: every element
+  // before base comes before the value, and the answer is at most base + len.
+  // Each step looks at the middle of the interval and moves base up if the
+  // middle element comes before the value. Once the interval is small enough,
+  // we count the elements in it that come before the value
+
+  const T *base = arr;
+  size_t len = n;
+
+  while (len > LINEAR_SEARCH_THRESHOLD) {
+    size_t half = len / 2;
+    base = comp(base[half], val) ? base + half : base;
+    len -= half;
+  }
+
+  return (base - arr) + linearRank(base, len, val, comp);
+}
+
+// this function will take a pointer to a sorted array, its size, a value and
+// a comparator, and return the position of the first element that comes after
+// the value (n if there is none)
+template <typename T, typename Compare = std::less<T>>
+size_t upperBound(const T *arr, size_t n, const T &val,
+                  Compare comp = Compare()) {
+  return lowerBound(arr, n, val, NotAfter<Compare>{comp});
+}
+
+// this function will take a pointer to a sorted array, its size, a value and
+// a comparator, and return the range [first, last) of positions whose
+// elements are equivalent to the value
+template <typename T, typename Compare = std::less<T>>
+std::pair<size_t, size_t> equalRange(const T *arr, size_t n, const T &val,
+                                     Compare comp = Compare()) {
+  size_t first = lowerBound(arr, n, val, comp);
+  size_t last = first + upperBound(arr + first, n - first, val, comp);
+  return std::make_pair(first, last);
+}
+
+// this function will take a pointer to a sorted array, its size, a value and
+// a comparator, and return true if an element equivalent to the value is in
+// the array, else false
+template <typename T, typename Compare = std::less<T>>
+bool contains(const T *arr, size_t n, const T &val, Compare comp = Compare()) {
+  size_t i = lowerBound(arr, n, val, comp);
+  return i < n && !comp(val, arr[i]);
+}
+
+// this alias is only valid if Compare can be called with two Ts and returns a
+// bool, so the compile time overloads use it to require a real comparator
+template <typename T, typename Compare>
+using IfComparator = std::enable_if_t<
+    std::is_invocable_r_v<bool, Compare, const T &, const T &>>;
+
+// this function does one halving step of the compile time search on an
+// interval of Len elements starting at base, and then calls itself for the
+// next step. Since Len is a template parameter, every step is a separate
+// function that the compiler inlines, so there is no loop left at the end
+template <size_t Len, typename T, typename Compare>
+constexpr size_t unrolledLowerBound(const T *arr, size_t base, const T &val,
+                                    Compare comp) {
+  if constexpr (Len <= 1) {
+    return base + (Len == 1 && comp(arr[base], val));
+  } else {
+    constexpr size_t half = Len / 2;
+    return unrolledLowerBound<Len - half>(
+        arr, comp(arr[base + half], val) ? base + half : base, val, comp);
+  }
+}
+
+// this function will take a reference to a sorted array of fixed size N, a
+// value and a comparator, and return the position of the first element that
+// doesn't come before the value (N if there is none)
+template <typename T, size_t N, typename Compare = std::less<T>,
+          typename = IfComparator<T, Compare>>
+constexpr size_t lowerBound(const T (&arr)[N], const T &val,
+                            Compare comp = Compare()) {
+  if constexpr (N <= 64)
+    return unrolledLowerBound<N>(arr, 0, val, comp);
+  else
+    return lowerBound(arr, N, val, comp);
+}
+
+// this function will take a reference to a sorted array of fixed size N, a
+// value and a comparator, and return the position of the first element that
+// comes after the value (N if there is none)
+template <typename T, size_t N, typename Compare = std::less<T>,
+          typename = IfComparator<T, Compare>>
+constexpr size_t upperBound(const T (&arr)[N], const T &val,
+                            Compare comp = Compare()) {
+  return lowerBound(arr, val, NotAfter<Compare>{comp});
+}
+
+// this function will take a reference to a sorted array of fixed size N, a
+// value and a comparator, and return the range [first, last) of positions
+// whose elements are equivalent to the value
+template <typename T, size_t N, typename Compare = std::less<T>,
+          typename = IfComparator<T, Compare>>
+constexpr std::pair<size_t, size_t>
+equalRange(const T (&arr)[N], const T &val, Compare comp = Compare()) {
+  return std::make_pair(lowerBound(arr, val, comp),
+                        upperBound(arr, val, comp));
+}
+
+// this function will take a reference to a sorted array of fixed size N, a
+// value and a comparator, and return true if an element equivalent to the
+// value is in the array, else false
+template <typename T, size_t N, typename Compare = std::less<T>,
+          typename = IfComparator<T, Compare>>
+constexpr bool contains(const T (&arr)[N], const T &val,
+                        Compare comp = Compare()) {
+  size_t i = lowerBound(arr, val, comp);
+  return i < N && !comp(val, arr[i]);
+}
+
+#endif
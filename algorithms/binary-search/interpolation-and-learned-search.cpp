@@ -0,0 +1,465 @@
+// This document contains implementations of interpolation search,
+// interpolation-sequential search and a small learned index, along with a
+// sampler that picks the fastest search mode for a given array, and a
+// benchmark comparing them to the recursive binary search in binary-search.cpp
+// on uniform, lognormal and clustered keys.
+
+// Definition of interpolation search (Wikipedia): interpolation search is an
+// algorithm for searching for a key in an array that has been ordered by
+// numerical values assigned to the keys.
+
+// Binary search always looks at the middle of the interval, no matter what the
+// keys look like. But if we are looking for the word "apple" in a dictionary,
+// we don't open it in the middle, we open it near the front. Interpolation
+// search does the same thing: if the keys are spread out evenly, the value
+// should be about (val - first) / (last - first) of the way through the
+// interval, so that's where we look. On uniformly distributed keys this takes
+// O(log(log(n))) probes on average, but on badly skewed keys it can take O(n)
+// probes, so the version below gives up after a fixed number of probes and
+// finishes with a binary search.
+
+// Interpolation-sequential search only makes ONE interpolation guess, and
+// then walks from the guess to the answer one element at a time. If the guess
+// is good, the walk is short and only touches one or two cache lines. Again,
+// if the walk gets too long we finish with a binary search.
+
+// A learned index takes the interpolation idea further: instead of assuming a
+// single straight line from the first key to the last, we learn a function
+// that maps a key to its position in the array. Here the function is made of
+// straight line pieces (a piecewise linear model), and each piece is built so
+// that its guess is never more than MAX_ERROR positions away from the real
+// position of any key it covers. A lookup finds the right piece (a binary
+// search over a much smaller array of pieces), makes a guess, and then does a
+// binary search over the small window of 2 * MAX_ERROR positions around the
+// guess (the "last mile").
+
+// Which of these modes is fastest depends on how the keys are distributed, so
+// the KeySearcher class below can sample the array and pick the best mode.
+
+#include "headers/binary-search.h" // the original recursive binary search to compare against
+#include <algorithm> // for lower_bound, sort and max
+#include <chrono>    // for timing the sampler and the benchmark
+#include <climits>   // for INT_MAX
+#include <cstdlib>   // for atol
+#include <iostream>  // basic input and output
+#include <random>    // for generating the benchmark key sets
+#include <vector>    // to be able to use vectors
+
+// the search modes the KeySearcher class can use
+enum SearchMode { BINARY, INTERPOLATION, INTERPOLATION_SEQUENTIAL, LEARNED };
+
+// the number of interpolation probes (or sequential steps) to make before
+// giving up and finishing with a binary search
+const int MAX_PROBES = 32;
+
+// the largest distance between the position the learned model guesses and the
+// real position of a key
+const int MAX_ERROR = 32;
+
+// this is a utility function that will take a sorted array, the bounds of an
+// interval [lo, hi) whose first element is less than the value and whose last
+// element is not less than the value, and return the position the value
+// would have if the keys were spread out evenly over the interval
+int interpolate(const int *arr, int lo, int hi, int val) {
+  double fraction =
+      ((double)val - arr[lo]) / ((double)arr[hi - 1] - arr[lo]);
+  return lo + (int)(fraction * (hi - 1 - lo));
+}
+
+// this function will take a pointer to a sorted int array, the bounds of an
+// interval [lo, hi) and a value. It returns the position of the first element
+// of the interval that is not less than the value (hi if there is none),
+// using interpolation search
+int interpolationLowerBound(const int *arr, int lo, int hi, int val) {
+  // the strategy is to check if the value is outside of the interval (in which
+  // case we're done), and if not, guess its position by interpolating between
+  // the first and last elements. Then we narrow down the interval to the side
+  // of the guess the value is on, and repeat
+
+  for (int probes = 0; lo < hi; probes++) {
+    if (val <= arr[lo])
+      return lo;
+    if (val > arr[hi - 1])
+      return hi;
+
+    // if the guesses aren't working out, finish with a binary search
+    if (probes == MAX_PROBES)
+      return std::lower_bound(arr + lo, arr + hi, val) - arr;
+
+    // here arr[lo] < val <= arr[hi - 1], so the answer is in (lo, hi - 1]
+    int pos = interpolate(arr, lo, hi, val);
+
+    if (arr[pos] < val)
+      lo = pos + 1; // the answer is after the guess
+    else
+      hi = pos; // the answer is the guess or before it (checked above)
+  }
+
+  return lo;
+}
+
+// this function will take a pointer to a sorted int array, the bounds of an
+// interval [lo, hi) and a value. It returns the position of the first element
+// of the interval that is not less than the value (hi if there is none),
+// using interpolation-sequential search
+int interpolationSequentialLowerBound(const int *arr, int lo, int hi,
+                                      int val) {
+  // the strategy is to make one interpolation guess and walk forward (if the
+  // element at the guess is less than the value) or backward (if the element
+  // before the guess is not less than the value) until we reach the answer
+
+  if (lo >= hi || val <= arr[lo])
+    return lo;
+  if (val > arr[hi - 1])
+    return hi;
+
+  int pos = interpolate(arr, lo, hi, val);
+
+  if (arr[pos] < val) {
+    // walk forward until the element is not less than the value
+    for (int steps = 0; steps < MAX_PROBES && arr[pos] < val; steps++)
+      pos++;
+
+    // if the walk was too long, binary search the rest
+    if (arr[pos] < val)
+      return std::lower_bound(arr + pos, arr + hi, val) - arr;
+  } else {
+    // walk backward while the element before is not less than the value
+    for (int steps = 0; steps < MAX_PROBES && pos > lo && arr[pos - 1] >= val;
+         steps++)
+      pos--;
+
+    // if the walk was too long, binary search the rest
+    if (pos > lo && arr[pos - 1] >= val)
+      return std::lower_bound(arr + lo, arr + pos, val) - arr;
+  }
+
+  return pos;
+}
+
+// this class represents the learned index. It contains a constructor that
+// builds the piecewise linear model from a sorted array, and a function to
+// find the lower bound of a value using the model
+class LearnedIndex {
+private:
+  const int *arr;                  // the sorted array the model was built on
+  int n;                           // the number of elements in the array
+  std::vector<int> firstKeys;      // the first key covered by each piece
+  std::vector<int> firstPositions; // the position of each piece's first key
+  std::vector<double> slopes;      // the slope of each piece
+
+public:
+  // constructor that will take a sorted array and its size, and build the
+  // model. The time complexity of this operation is O(n)
+  LearnedIndex(const int *arr, int n) {
+    // the strategy is to grow each piece one key at a time. A piece starts at
+    // some key x0 (at position y0) and every line through (x0, y0) is
+    // described by its slope. For every key x (at position y) that the piece
+    // covers, the line has to pass within MAX_ERROR of y, which only allows
+    // slopes between (y - y0 - MAX_ERROR) / (x - x0) and
+    // (y - y0 + MAX_ERROR) / (x - x0). We keep the range of slopes that works
+    // for every key seen so far (this is sometimes called a shrinking cone),
+    // and once a key would make that range empty, we end the piece and start
+    // a new one at that key. The slope of a piece is the middle of its range
+
+    this->arr = arr;
+    this->n = n;
+
+    int i = 0;
+    while (i < n) {
+      int x0 = arr[i], y0 = i;
+      double lowSlope = 0, highSlope = 1e300; // the slopes that still work
+
+      for (i = i + 1; i < n; i++) {
+        double dx = (double)arr[i] - x0;
+        double dy = i - y0;
+
+        // keys equal to the first key are guessed as exactly y0
+        if (dx == 0) {
+          if (dy > MAX_ERROR)
+            break;
+          continue;
+        }
+
+        double low = std::max(lowSlope, (dy - MAX_ERROR) / dx);
+        double high = std::min(highSlope, (dy + MAX_ERROR) / dx);
+
+        if (low > high)
+          break; // no line works for this key, so it starts a new piece
+
+        lowSlope = low;
+        highSlope = high;
+      }
+
+      this->firstKeys.push_back(x0);
+      this->firstPositions.push_back(y0);
+      this->slopes.push_back(highSlope == 1e300 ? lowSlope
+                                                : (lowSlope + highSlope) / 2);
+    }
+  }
+
+  // this function will take a value and return the position of the first
+  // element in the array that is not less than the value (n if there is none)
+  int lowerBound(int val) {
+    // find the last piece whose first key is less than the value. A run of
+    // equal keys can be split across pieces, so a piece starting with the
+    // value itself might not hold its first occurence, but the piece before
+    // it does (or ends right before it). If there is no such piece, the value
+    // is not greater than any key
+    int piece = std::lower_bound(this->firstKeys.begin(),
+                                 this->firstKeys.end(), val) -
+                this->firstKeys.begin() - 1;
+    if (piece < 0)
+      return 0;
+
+    // the answer can't be before the start of this piece, or after the start
+    // of the next one
+    int pieceStart = this->firstPositions[piece];
+    int pieceEnd = piece + 1 < (int)this->firstPositions.size()
+                       ? this->firstPositions[piece + 1]
+                       : this->n;
+
+    // guess the position with the model, and search the window around it. The
+    // extra 1 in the window covers values that fall between two keys
+    double guess = pieceStart +
+                   this->slopes[piece] * ((double)val - this->firstKeys[piece]);
+    double lo = std::max((double)pieceStart, guess - MAX_ERROR - 1);
+    double hi = std::min((double)pieceEnd, guess + MAX_ERROR + 2);
+
+    if (lo >= hi)
+      return pieceEnd; // the value is past the last key of this piece
+
+    return std::lower_bound(this->arr + (int)lo, this->arr + (int)hi, val) -
+           this->arr;
+  }
+
+  // this is a utility function that returns the number of pieces in the model
+  int size() { return this->firstKeys.size(); }
+};
+
+// this class represents a searcher over one sorted array, which can use any of
+// the search modes above. It contains a function to pick the fastest mode for
+// the array by sampling it, and a search function with the same return value
+// as binarySearch
+class KeySearcher {
+private:
+  int *arr;           // the sorted array being searched
+  int n;              // the number of elements in the array
+  LearnedIndex model; // the learned model (used by the LEARNED mode)
+  long long checksum; // the sum of the sampler's results, kept so the
+                      // compiler can't skip the searches while timing them
+
+public:
+  SearchMode mode; // the search mode to use
+
+  // constructor that will take a sorted array and its size. It builds the
+  // learned model and starts off using the regular binary search
+  KeySearcher(int *arr, int n) : model(arr, n) {
+    this->arr = arr;
+    this->n = n;
+    this->mode = BINARY;
+    this->checksum = 0;
+  }
+
+  // this function will take a value and return the location of the value in
+  // the array if it is found, using the current mode. Else it returns -1.
+  // Apart from BINARY, every mode returns the first occurence of the value
+  int search(int val) {
+    int i;
+
+    switch (this->mode) {
+    case BINARY:
+      return binarySearch(this->arr, 0, this->n - 1, val);
+    case INTERPOLATION:
+      i = interpolationLowerBound(this->arr, 0, this->n, val);
+      break;
+    case INTERPOLATION_SEQUENTIAL:
+      i = interpolationSequentialLowerBound(this->arr, 0, this->n, val);
+      break;
+    default:
+      i = this->model.lowerBound(val);
+      break;
+    }
+
+    return (i < this->n && this->arr[i] == val) ? i : -1;
+  }
+
+  // this function will time every mode on a sample of the keys in the array
+  // (plus some random values in between them), switch to the fastest one, and
+  // return it
+  SearchMode chooseMode() {
+    // the strategy is to build a sample of queries which are half keys picked
+    // from the array and half values near them (most of which will be misses),
+    // then run every mode over the sample and keep the one that took the
+    // least time
+    if (this->n == 0)
+      return this->mode; // there is nothing to sample
+
+    const int sampleSize = 10000;
+    std::vector<int> sample(sampleSize);
+    std::mt19937 rng(12345);
+
+    for (int i = 0; i < sampleSize; i++) {
+      int key = this->arr[rng() % this->n];
+      sample[i] = (i % 2 || key == INT_MAX) ? key : key + 1;
+    }
+
+    SearchMode modes[] = {BINARY, INTERPOLATION, INTERPOLATION_SEQUENTIAL,
+                          LEARNED};
+    SearchMode best = BINARY;
+    double bestTime = 1e300;
+
+    for (SearchMode m : modes) {
+      this->mode = m;
+
+      auto begin = std::chrono::steady_clock::now();
+      for (int q : sample)
+        this->checksum += search(q);
+      auto finish = std::chrono::steady_clock::now();
+
+      double time = std::chrono::duration<double>(finish - begin).count();
+      if (time < bestTime) {
+        bestTime = time;
+        best = m;
+      }
+    }
+
+    this->mode = best;
+    return this->mode;
+  }
+};
+
+// this is a utility function that returns the name of a search mode
+const char *modeName(SearchMode mode) {
+  switch (mode) {
+  case BINARY:
+    return "binary";
+  case INTERPOLATION:
+    return "interpolation";
+  case INTERPOLATION_SEQUENTIAL:
+    return "interpolation-sequential";
+  default:
+    return "learned";
+  }
+}
+
+// main function, which is just driver code to test and benchmark the above
+int main(int argc, char *argv[]) {
+  int array[] = {2, 3, 4, 10, 40}; // a static array to test the modes on
+  int size = sizeof(array) / sizeof(array[0]); // finding the size of the array
+
+  KeySearcher small(array, size);
+  small.mode = INTERPOLATION;
+  std::cout << "Element " << 10 << " found at index: " << small.search(10)
+            << std::endl;
+
+  // a long run of equal keys is split across several pieces of the learned
+  // model, so make sure every mode still finds the first occurence of each
+  // key in it
+  std::vector<int> runs(100, 5);
+  for (int key = 10; key < 110; key++)
+    runs.push_back(key);
+
+  KeySearcher withRuns(runs.data(), runs.size());
+  for (SearchMode m : {INTERPOLATION, INTERPOLATION_SEQUENTIAL, LEARNED}) {
+    withRuns.mode = m;
+    for (int val = 0; val <= 110; val++) {
+      auto first = std::lower_bound(runs.begin(), runs.end(), val);
+      int expected = (first != runs.end() && *first == val)
+                         ? first - runs.begin()
+                         : -1;
+      if (withRuns.search(val) != expected) {
+        std::cout << "Wrong index in " << modeName(m)
+                  << " mode when searching for " << val << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  // BENCHMARK
+  // we generate n keys (1M by default, or the first argument) from three
+  // different distributions, and time every mode on random queries (half of
+  // them keys from the array and half random values in the same range)
+  int n = std::max(argc > 1 ? (int)std::atol(argv[1]) : 1000000, 1);
+  const int numQueries = 1000000;
+  const char *distributions[] = {"uniform", "lognormal", "clustered"};
+
+  std::mt19937 rng(42);
+
+  for (int d = 0; d < 3; d++) {
+    std::vector<int> arr(n);
+
+    if (d == 0) {
+      // uniform: keys spread evenly over [0, 2^30)
+      std::uniform_int_distribution<int> dist(0, 1 << 30);
+      for (int &key : arr)
+        key = dist(rng);
+    } else if (d == 1) {
+      // lognormal: most keys are small, with a long tail of large ones
+      std::lognormal_distribution<double> dist(0, 2);
+      for (int &key : arr)
+        key = (int)std::min(dist(rng) * 1000, 2e9);
+    } else {
+      // clustered: keys bunched up tightly around 100 random centers
+      std::uniform_int_distribution<int> centers(0, 1 << 30);
+      std::normal_distribution<double> offset(0, 1000);
+      std::vector<int> c(100);
+      for (int &center : c)
+        center = centers(rng);
+      for (int &key : arr)
+        key = c[rng() % c.size()] + (int)offset(rng);
+    }
+
+    std::sort(arr.begin(), arr.end());
+
+    std::vector<int> queries(numQueries);
+    for (int i = 0; i < numQueries; i++) {
+      if (i % 2)
+        queries[i] = arr[rng() % n];
+      else
+        queries[i] = arr[0] + rng() % ((long long)arr[n - 1] - arr[0] + 1);
+    }
+
+    KeySearcher searcher(arr.data(), n);
+    std::cout << distributions[d] << " keys (" << n << " keys, "
+              << LearnedIndex(arr.data(), n).size() << " model pieces)"
+              << std::endl;
+
+    SearchMode modes[] = {BINARY, INTERPOLATION, INTERPOLATION_SEQUENTIAL,
+                          LEARNED};
+    std::vector<int> expected(numQueries);
+
+    for (SearchMode m : modes) {
+      searcher.mode = m;
+      std::vector<int> results(numQueries);
+
+      auto begin = std::chrono::steady_clock::now();
+      for (int i = 0; i < numQueries; i++)
+        results[i] = searcher.search(queries[i]);
+      auto finish = std::chrono::steady_clock::now();
+
+      // make sure every mode finds the same keys (the indices of duplicate
+      // keys can differ, so we compare the elements that were found)
+      for (int i = 0; i < numQueries; i++) {
+        if (m == BINARY)
+          expected[i] = results[i] == -1 ? -1 : arr[results[i]];
+        else if (expected[i] != (results[i] == -1 ? -1 : arr[results[i]])) {
+          std::cout << "Mismatch in " << modeName(m)
+                    << " mode when searching for " << queries[i] << std::endl;
+          return 1;
+        }
+      }
+
+      std::cout << "  " << modeName(m) << ": "
+                << std::chrono::duration<double, std::nano>(finish - begin)
+                           .count() /
+                       numQueries
+                << " ns" << std::endl;
+    }
+
+    std::cout << "  sampler picked: " << modeName(searcher.chooseMode())
+              << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,310 @@
+// This document contains an implementation of a search engine for sorted
+// files of fixed width keys that are too big to comfortably read into memory,
+// along with a function that writes the file format from an in-memory array.
+
+// To use binarySearch on a file, we would have to read the whole file into an
+// array first, even if we only want to look up a handful of keys. Instead, we
+// can ask the operating system to map the file into memory (mmap). The file
+// then looks like a regular array, but nothing is actually read from disk until
+// we touch it, and then only the page (4KB) we touched is read. The operating
+// system also keeps the pages we've read in its page cache, so we don't need
+// to make a copy of anything (this is called zero-copy).
+
+// A binary search over the mapped file would still touch about log2(n) pages,
+// and every one of those could be a read from disk. So the file also stores a
+// sparse index: the first key of every page. The index is small (one key per
+// page), so we copy it into memory when the file is opened. A lookup binary
+// searches the index to find the one page that can contain the value, and
+// then only binary searches inside that page, so it only ever touches ONE page
+// of the file.
+
+// We also give the operating system hints about how we'll use the mapping
+// (madvise): MADV_RANDOM for point lookups, so it doesn't waste time reading
+// ahead, or MADV_SEQUENTIAL for scans, so it does.
+
+// The file format is:
+//    - a header (magic bytes, key width, keys per page, number of keys and
+//    where the sparse index starts), padded to a full page
+//    - the keys, in sorted order, starting at the second page of the file
+//    - the sparse index (the first key of every page of keys)
+
+// This uses POSIX functions (open, mmap, madvise), so it works on Linux and
+// macOS but not on Windows.
+
+#include "headers/binary-search.h" // the original recursive binary search to compare against
+#include <algorithm>  // for lower_bound
+#include <chrono>     // for timing the lookups
+#include <cstdint>    // for fixed width integer types
+#include <cstdio>     // for fopen, fwrite and remove
+#include <cstring>    // for memcmp and memcpy
+#include <fcntl.h>    // for open
+#include <iostream>   // basic input and output
+#include <sys/mman.h> // for mmap, munmap and madvise
+#include <sys/stat.h> // for fstat
+#include <unistd.h>   // for close
+#include <vector>     // to be able to use vectors
+
+const size_t PAGE_SIZE = 4096; // the size of a page of the file
+const char MAGIC[8] = {'S', 'O', 'R', 'T', 'K', 'E', 'Y', 'S'};
+
+// the header at the start of every sorted key file
+struct SortedFileHeader {
+  char magic[8];        // always MAGIC, so we can tell it's the right format
+  uint32_t keyWidth;    // the size of a key in bytes
+  uint32_t keysPerPage; // the number of keys in a page
+  uint64_t count;       // the number of keys in the file
+  uint64_t indexOffset; // where the sparse index starts in the file
+};
+
+// this function will take a path, a pointer to a sorted array of keys and the
+// number of keys, and write them to the file at the path in the format
+// described above. It returns true if the file was written, else false
+template <typename T>
+bool writeSortedFile(const char *path, const T *keys, size_t n) {
+  // the strategy is to write the header and pad it to a full page, then write
+  // all the keys, and finally write the first key of every page of keys
+
+  FILE *file = std::fopen(path, "wb");
+  if (!file)
+    return false;
+
+  SortedFileHeader header;
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.keyWidth = sizeof(T);
+  header.keysPerPage = PAGE_SIZE / sizeof(T);
+  header.count = n;
+  header.indexOffset = PAGE_SIZE + n * sizeof(T);
+
+  std::vector<char> firstPage(PAGE_SIZE, 0);
+  std::memcpy(firstPage.data(), &header, sizeof(header));
+
+  bool ok = std::fwrite(firstPage.data(), 1, PAGE_SIZE, file) == PAGE_SIZE &&
+            std::fwrite(keys, sizeof(T), n, file) == n;
+
+  for (size_t i = 0; ok && i < n; i += header.keysPerPage)
+    ok = std::fwrite(keys + i, sizeof(T), 1, file) == 1;
+
+  return std::fclose(file) == 0 && ok;
+}
+
+// this class represents a sorted key file that has been mapped into memory. It
+// contains functions to open and close the file, hint at how it will be used,
+// find the lower bound of a value and search for a value. The keys are never
+// copied: all the functions read them straight out of the mapping
+template <typename T> class MappedSortedFile {
+private:
+  void *mapping = nullptr; // the start of the mapped file
+  size_t mappingSize = 0;  // the size of the mapped file
+  const T *keys = nullptr; // the keys in the mapping
+  size_t n = 0;            // the number of keys
+  size_t keysPerPage = 0;  // the number of keys in a page
+  std::vector<T> sparse;   // the first key of every page (copied into memory)
+
+public:
+  MappedSortedFile() = default;
+  ~MappedSortedFile() { close(); }
+
+  // the mapping belongs to this object, so copying it would unmap it twice
+  MappedSortedFile(const MappedSortedFile &) = delete;
+  MappedSortedFile &operator=(const MappedSortedFile &) = delete;
+
+  // this function will take a path and map the sorted key file at that path.
+  // It returns true if the file was opened, else false (if the file doesn't
+  // exist, or isn't a sorted key file with keys of type T)
+  bool open(const char *path) {
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+      return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < PAGE_SIZE) {
+      ::close(fd);
+      return false;
+    }
+
+    // map the whole file. The file descriptor isn't needed once it's mapped
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+      return false;
+
+    // check the header matches what we expect, and that the keys and the
+    // sparse index it describes are inside the file (a truncated or corrupt
+    // file would otherwise make us read past the end of the mapping). The
+    // count is checked first, so none of the sizes below can overflow
+    const SortedFileHeader *header = (const SortedFileHeader *)map;
+    size_t fileSize = st.st_size;
+    size_t keysEnd = 0, indexBytes = 0;
+
+    bool valid = std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+                 header->keyWidth == sizeof(T) &&
+                 header->keysPerPage == PAGE_SIZE / sizeof(T) &&
+                 header->count <= (fileSize - PAGE_SIZE) / sizeof(T);
+
+    if (valid) {
+      keysEnd = PAGE_SIZE + header->count * sizeof(T);
+      indexBytes = (header->count + header->keysPerPage - 1) /
+                   header->keysPerPage * sizeof(T);
+
+      valid = header->indexOffset % sizeof(T) == 0 &&
+              keysEnd <= header->indexOffset &&
+              header->indexOffset <= fileSize &&
+              indexBytes <= fileSize - header->indexOffset &&
+              header->indexOffset + indexBytes == fileSize;
+    }
+
+    if (!valid) {
+      munmap(map, st.st_size);
+      return false;
+    }
+
+    this->mapping = map;
+    this->mappingSize = st.st_size;
+    this->keys = (const T *)((const char *)map + PAGE_SIZE);
+    this->n = header->count;
+    this->keysPerPage = header->keysPerPage;
+
+    // copy the sparse index into memory, since every lookup uses it
+    const T *index = (const T *)((const char *)map + header->indexOffset);
+    size_t pages = (this->n + this->keysPerPage - 1) / this->keysPerPage;
+    this->sparse.assign(index, index + pages);
+
+    // by default we expect point lookups, so reading ahead is wasted work
+    advise(false);
+
+    return true;
+  }
+
+  // this function will unmap the file, if one is mapped
+  void close() {
+    if (this->mapping)
+      munmap(this->mapping, this->mappingSize);
+
+    this->mapping = nullptr;
+    this->keys = nullptr;
+    this->n = 0;
+    this->sparse.clear();
+  }
+
+  // this function tells the operating system how the keys will be read. If
+  // sequential is true, the keys will be scanned in order, so the operating
+  // system should read ahead. Else they will be read in random places, so it
+  // shouldn't
+  void advise(bool sequential) {
+    if (this->mapping)
+      madvise(this->mapping, this->mappingSize,
+              sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+  }
+
+  // this function asks the operating system to start reading the whole file
+  // into its page cache in the background, so later lookups don't wait on disk
+  void warmUp() {
+    if (this->mapping)
+      madvise(this->mapping, this->mappingSize, MADV_WILLNEED);
+  }
+
+  // this function will take a value and return the position of the first key
+  // in the file that is not less than the value (the number of keys if there
+  // is none)
+  size_t lowerBound(const T &val) {
+    // the strategy is to find the first page whose first key is not less than
+    // the value. The answer is either the first key of that page, or it's in
+    // the page before it, so we binary search the page before it (which is
+    // the only page of keys we touch)
+
+    size_t page = std::lower_bound(this->sparse.begin(), this->sparse.end(),
+                                   val) -
+                  this->sparse.begin();
+
+    if (page == 0)
+      return 0; // the first key is not less than the value
+
+    size_t start = (page - 1) * this->keysPerPage;
+    size_t end = std::min(page * this->keysPerPage, this->n);
+
+    return std::lower_bound(this->keys + start, this->keys + end, val) -
+           this->keys;
+  }
+
+  // this function will take a value and return its position in the file if it
+  // is found. Else it returns -1
+  long search(const T &val) {
+    size_t i = lowerBound(val);
+    return (i < this->n && this->keys[i] == val) ? (long)i : -1;
+  }
+
+  // this function returns a pointer to the keys in the mapping, so they can be
+  // read directly without copying them
+  const T *data() { return this->keys; }
+
+  // this is a utility function that returns the number of keys in the file
+  size_t size() { return this->n; }
+};
+
+// main function, which is just driver code to test out the above. The path of
+// the file to write and search can be passed as the first argument
+int main(int argc, char *argv[]) {
+  const char *path = argc > 1 ? argv[1] : "/tmp/sorted-keys.bin";
+  const int n = 10000000; // the number of keys to write
+
+  // write the even numbers to a sorted key file
+  std::vector<int> arr(n);
+  for (int i = 0; i < n; i++)
+    arr[i] = 2 * i;
+
+  if (!writeSortedFile(path, arr.data(), arr.size())) {
+    std::cout << "Could not write " << path << std::endl;
+    return 1;
+  }
+
+  MappedSortedFile<int> file;
+  if (!file.open(path)) {
+    std::cout << "Could not open " << path << std::endl;
+    return 1;
+  }
+
+  std::cout << "Mapped " << file.size() << " keys from " << path << std::endl;
+  std::cout << "Element " << 10 << " found at index: " << file.search(10)
+            << std::endl;
+  std::cout << "Search for " << 11 << ": " << file.search(11) << std::endl;
+
+  // look up random values in the file and make sure they match the recursive
+  // binary search over the in-memory array
+  const int numQueries = 1000000;
+  unsigned long long seed = 88172645463325252ULL;
+  long long expectedSum = 0, fileSum = 0;
+
+  std::vector<int> queries(numQueries);
+  for (int &q : queries) {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    q = seed % (2 * n);
+  }
+
+  for (int q : queries)
+    expectedSum += binarySearch(arr.data(), 0, n - 1, q);
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int q : queries)
+    fileSum += file.search(q);
+  auto finish = std::chrono::steady_clock::now();
+
+  if (expectedSum != fileSum) {
+    std::cout << "Results differ from binarySearch" << std::endl;
+    return 1;
+  }
+
+  std::cout << "Average lookup: "
+            << std::chrono::duration<double, std::nano>(finish - begin)
+                       .count() /
+                   numQueries
+            << " ns" << std::endl;
+
+  file.close();
+  std::remove(path); // clean up the file we wrote
+
+  return 0;
+}
@@ -0,0 +1,164 @@
+// This document contains an implementation of a merge-style binary search for
+// batches of queries, along with a benchmark comparing it to calling the
+// recursive binary search in binary-search.cpp once per query.
+
+// When we have a whole batch of keys to look up, calling binarySearch for each
+// one starts every search from scratch over the whole array, so q queries cost
+// O(q * log(n)) comparisons and jump all over the array. But if the queries
+// are sorted, the answer to each query can't be before the answer to the one
+// before it. So we can sort the queries first, and then sweep through the
+// array once (just like the merge step of merge sort), with each search
+// resuming from where the previous one landed.
+
+// To jump ahead quickly when the next query is far away, each search uses
+// galloping (also called exponential search): starting from the previous
+// position, check 1, 2, 4, 8, ... elements ahead until we pass the key, and
+// then do a regular binary search in the last range we jumped over. If the
+// next answer is d positions away, this only takes O(log(d)) comparisons.
+
+// Sorting the queries takes O(q * log(q)) time (or O(q) time to check that
+// they are already sorted). The sweep takes O(q * log(n / q)) time, which is
+// close to a linear scan through the array when q is close to n, and all of
+// the memory accesses move forward through the array.
+
+#include "headers/binary-search.h" // the original recursive binary search to compare against
+#include <algorithm> // for sort, is_sorted and lower_bound
+#include <chrono>    // for timing the benchmark
+#include <cstdlib>   // for atol
+#include <iostream>  // basic input and output
+#include <vector>    // to be able to use vectors
+
+// this function will take a pointer to a sorted int array, the position to
+// start from, the end of the interval, and a key. Assuming every element
+// before pos is less than the key, it returns the position of the first
+// element that is not less than the key (or end + 1 if there is none)
+int gallop(const int *arr, int pos, int end, int key) {
+  // the strategy is to double the distance we look ahead until we either run
+  // off the end of the interval or find an element that is not less than the
+  // key. The answer is then somewhere between the last two places we looked,
+  // so we finish with a binary search over that range
+
+  int bound = 1;
+  while (pos + bound <= end && arr[pos + bound] < key)
+    bound *= 2;
+
+  // arr[pos + bound / 2] is less than the key (or it's pos itself), and the
+  // answer is at most pos + bound (or end + 1 if we ran off the end)
+  const int *lo = arr + pos + bound / 2;
+  const int *hi = arr + std::min(pos + bound, end) + 1;
+
+  return std::lower_bound(lo, hi, key) - arr;
+}
+
+// this function will take a pointer to a sorted int array, an interval start
+// and an interval end (just like binarySearch), as well as an array of n keys
+// to search for and an output array of size n. For every key, it stores the
+// location of the key in the output array, or -1 if the key isn't found. The
+// results are stored in the same order as the keys, whether or not the keys
+// were sorted. If a key occurs more than once in the array, the first
+// occurence is returned
+void binarySearchMerge(int *arr, int start, int end, const int *keys, int n,
+                       int *out) {
+  // the strategy is to sort the positions of the queries by their keys
+  // (unless they're already sorted). Then we go through the queries in sorted
+  // order, galloping forward from where the last query landed, and store each
+  // result at the original position of its query
+
+  std::vector<int> order(n); // the positions of the queries in sorted order
+  for (int i = 0; i < n; i++)
+    order[i] = i;
+
+  // only sort the queries if they aren't sorted already
+  if (!std::is_sorted(keys, keys + n))
+    std::sort(order.begin(), order.end(),
+              [keys](int a, int b) { return keys[a] < keys[b]; });
+
+  int pos = start; // where the previous search landed
+
+  for (int i : order) {
+    pos = gallop(arr, pos, end, keys[i]);
+    out[i] = (pos <= end && arr[pos] == keys[i]) ? pos : -1;
+  }
+}
+
+// main function, which is just driver code to test and benchmark the above
+int main(int argc, char *argv[]) {
+  int array[] = {2, 3, 4, 10, 40}; // a static array to test the function on
+  int size = sizeof(array) / sizeof(array[0]); // finding the size of the array
+
+  int keys[] = {40, 12, 2, 10, 41, 0, 10}; // the (unsorted) keys to look up
+  int numKeys = sizeof(keys) / sizeof(keys[0]);
+  int results[sizeof(keys) / sizeof(keys[0])];
+
+  binarySearchMerge(array, 0, size - 1, keys, numKeys, results);
+
+  for (int i = 0; i < numKeys; i++) {
+    // make sure the merge search agrees with the recursive one
+    if (results[i] != binarySearch(array, 0, size - 1, keys[i])) {
+      std::cout << "Mismatch when searching for " << keys[i] << std::endl;
+      return 1;
+    }
+
+    (results[i] != -1)
+        ? std::cout << "Element " << keys[i]
+                    << " found at index: " << results[i] << std::endl
+        : std::cout << "Element " << keys[i] << " not found in array."
+                    << std::endl;
+  }
+
+  // BENCHMARK
+  // we look up a batch of 1M random queries in arrays of 1K, 1M and 100M even
+  // numbers. The time for the merge search includes sorting the queries
+  long maxSize = argc > 1 ? std::atol(argv[1]) : 100000000;
+  long sizes[] = {1000, 1000000, 100000000};
+  const int numQueries = 1000000;
+
+  std::cout << "size\trecursive (ns)\tmerge (ns)" << std::endl;
+
+  for (long n : sizes) {
+    if (n > maxSize)
+      break;
+
+    std::vector<int> arr(n);
+    for (long i = 0; i < n; i++)
+      arr[i] = 2 * i;
+
+    // generate the queries with a simple xorshift random number generator
+    std::vector<int> queries(numQueries);
+    unsigned long long seed = 88172645463325252ULL;
+    for (int &q : queries) {
+      seed ^= seed << 13;
+      seed ^= seed >> 7;
+      seed ^= seed << 17;
+      q = seed % (2 * n);
+    }
+
+    std::vector<int> expected(numQueries), merged(numQueries);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < numQueries; i++)
+      expected[i] = binarySearch(arr.data(), 0, n - 1, queries[i]);
+    auto middle = std::chrono::steady_clock::now();
+    binarySearchMerge(arr.data(), 0, n - 1, queries.data(), numQueries,
+                      merged.data());
+    auto finish = std::chrono::steady_clock::now();
+
+    // since all the keys are distinct, both searches must agree exactly
+    if (expected != merged) {
+      std::cout << "Results differ for size " << n << std::endl;
+      return 1;
+    }
+
+    std::cout << n << "\t"
+              << std::chrono::duration<double, std::nano>(middle - begin)
+                         .count() /
+                     numQueries
+              << "\t\t"
+              << std::chrono::duration<double, std::nano>(finish - middle)
+                         .count() /
+                     numQueries
+              << std::endl;
+  }
+
+  return 0;
+}
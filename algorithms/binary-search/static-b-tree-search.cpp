@@ -0,0 +1,270 @@
+// This document contains an implementation of a static B-tree (also called an
+// S-tree), which is a read-only search index built from a sorted array, along
+// with a benchmark comparing it to the recursive binary search in
+// binary-search.cpp.
+
+// Definition of a B-tree (Wikipedia): a B-tree is a self-balancing tree data
+// structure that maintains sorted data and allows searches, sequential access,
+// insertions, and deletions in logarithmic time. Unlike a binary search tree,
+// a node of a B-tree can hold more than one key and have more than two
+// children.
+
+// Binary search does one comparison per level, and on a big array almost every
+// level is a cache miss. But when the CPU loads something from memory, it
+// always loads a whole cache line (64 bytes, or 16 ints), so it is wasteful to
+// only look at one of those ints. In a static B-tree, every node holds exactly
+// 16 keys (one cache line) and has 17 children. Searching a node tells us
+// which of the 17 children to go to next, so a lookup only touches about
+// log17(n) cache lines instead of log2(n).
+
+// Since the tree is never modified after it's built, we don't need to store
+// any pointers. Just like a heap, the nodes are stored in one array, and the
+// children of node k are the nodes k * 17 + 1 to k * 17 + 17. The last node
+// is padded with INT_MAX.
+
+// To search inside a node, we count how many of its keys are less than the
+// value. With AVX2, we can compare 8 keys at once with a single instruction,
+// turn the result into a bitmask (movemask), and count the set bits
+// (popcount). So a whole node is searched in a handful of instructions with no
+// branches. If AVX2 isn't available, a plain loop is used instead.
+
+// Building the tree takes O(n) time. Every query runs in O(log(n)) time, but
+// only touches O(log17(n)) cache lines.
+
+// compile with g++ -O2 -mavx2 (or -march=native) to use the SIMD node search.
+// The benchmark sizes can be limited by passing the largest size to run as the
+// first argument (default is 100M elements).
+
+#include "headers/binary-search.h" // the original recursive binary search to compare against
+#include <chrono>   // for timing the benchmark
+#include <climits>  // for INT_MAX
+#include <cstdlib>  // for aligned_alloc, free and atol
+#include <iostream> // basic input and output
+#include <utility>  // for std::pair
+#include <vector>   // to be able to use vectors
+
+#ifdef __AVX2__
+#include <immintrin.h> // for the AVX2 intrinsics
+#endif
+
+// this class represents the static B-tree. It contains a constructor that
+// builds the tree from a sorted array, and functions to find the lower bound,
+// upper bound and equal range of a value. All the functions return indices
+// into the original sorted array. It also contains a search function which
+// returns the same thing as the recursive binarySearch
+class STree {
+private:
+  static const int B = 16; // the number of keys in each node
+
+  int *keys;    // the keys of every node, B keys per node
+  int *indices; // the position each key had in the original sorted array
+  int n;        // the number of keys in the tree
+  int nblocks;  // the number of nodes in the tree
+
+  // this function will take the index of a node and i, and return the index of
+  // the i-th child of that node (0 <= i <= B)
+  int child(int k, int i) { return k * (B + 1) + i + 1; }
+
+  // this function will recursively walk the tree in order (child 0, key 0,
+  // child 1, key 1, ..., key 15, child 16) and fill in each key with the next
+  // element of the sorted array. The slots left over once the array runs out
+  // are padded with INT_MAX. t is the position of the next element to place
+  void build(const int *sorted, int &t, int k) {
+    if (k < this->nblocks) {
+      for (int i = 0; i < B; i++) {
+        build(sorted, t, child(k, i));
+
+        if (t < this->n) {
+          this->keys[k * B + i] = sorted[t];
+          this->indices[k * B + i] = t++;
+        } else {
+          this->keys[k * B + i] = INT_MAX;
+          this->indices[k * B + i] = this->n;
+        }
+      }
+
+      build(sorted, t, child(k, B));
+    }
+  }
+
+  // this function will take a node and a value, and count how many keys in
+  // the node are less than the value (or less than or equal to the value, if
+  // upper is true). Since the keys in a node are sorted, this count is also
+  // the position of the first key that is not less than the value
+  int rank(const int *node, int val, bool upper) {
+#ifdef __AVX2__
+    // the strategy is to load the 16 keys into two vectors of 8 and compare
+    // all of them with the value at once. For the lower bound we want the keys
+    // less than the value (val > key), and for the upper bound we want the
+    // keys greater than the value (key > val) and subtract that count from B
+    __m256i x = _mm256_set1_epi32(val);
+    __m256i a = _mm256_load_si256((const __m256i *)node);
+    __m256i b = _mm256_load_si256((const __m256i *)(node + 8));
+
+    __m256i ca = upper ? _mm256_cmpgt_epi32(a, x) : _mm256_cmpgt_epi32(x, a);
+    __m256i cb = upper ? _mm256_cmpgt_epi32(b, x) : _mm256_cmpgt_epi32(x, b);
+
+    // turn each comparison result into one bit and combine both halves
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(ca)) |
+               (_mm256_movemask_ps(_mm256_castsi256_ps(cb)) << 8);
+    int count = __builtin_popcount(mask);
+
+    return upper ? B - count : count;
+#else
+    // without AVX2, just count the keys one by one (the compiler can still
+    // unroll and vectorize this loop)
+    int count = 0;
+    for (int i = 0; i < B; i++)
+      count += upper ? (node[i] <= val) : (node[i] < val);
+    return count;
+#endif
+  }
+
+  // this function will return the position (in the sorted array) of the first
+  // key that is not less than the value (or greater than the value, if upper
+  // is true). If there is no such key, it returns n
+  int bound(int val, bool upper) {
+    // the strategy is to start at the root and find the first key in the node
+    // that is not less than the value. That key is our best answer so far, and
+    // every key in the subtree to its left is smaller than it, so we go down
+    // into that subtree and look for something even better. If every key in
+    // the node is less than the value, we go to the last child and keep our
+    // current answer
+
+    int result = this->n;
+    int k = 0;
+
+    while (k < this->nblocks) {
+      int i = rank(this->keys + k * B, val, upper);
+
+      if (i < B)
+        result = this->indices[k * B + i];
+
+      k = child(k, i);
+    }
+
+    return result;
+  }
+
+public:
+  // constructor that will take a sorted array and its size, and build the
+  // tree from it. The time complexity of this operation is O(n)
+  STree(const int *sorted, int n) {
+    this->n = n;
+    this->nblocks = (n + B - 1) / B;
+
+    // the keys are aligned to a cache line so that every node takes up
+    // exactly one cache line (and so the AVX2 aligned loads work)
+    size_t slots = (size_t)(this->nblocks > 0 ? this->nblocks : 1) * B;
+    this->keys = (int *)std::aligned_alloc(64, slots * sizeof(int));
+    this->indices = new int[slots];
+
+    int t = 0; // the position of the next sorted element to place
+    build(sorted, t, 0);
+  }
+
+  ~STree() {
+    std::free(this->keys);
+    delete[] this->indices;
+  }
+
+  // the tree owns its arrays, so copying it would free them twice
+  STree(const STree &) = delete;
+  STree &operator=(const STree &) = delete;
+
+  // this function will take a value and return the index of the first element
+  // in the sorted array that is not less than the value (n if there is none)
+  int lowerBound(int val) { return bound(val, false); }
+
+  // this function will take a value and return the index of the first element
+  // in the sorted array that is greater than the value (n if there is none)
+  int upperBound(int val) { return bound(val, true); }
+
+  // this function will take a value and return the range [first, last) of
+  // indices in the sorted array whose elements are equal to the value
+  std::pair<int, int> equalRange(int val) {
+    return std::make_pair(lowerBound(val), upperBound(val));
+  }
+
+  // this function will take a sorted array (the one the tree was built from)
+  // and a value, and return the index of the value if it is found. Else it
+  // returns -1
+  int search(const int *sorted, int val) {
+    int i = lowerBound(val);
+    return (i < this->n && sorted[i] == val) ? i : -1;
+  }
+};
+
+// main function, which is just driver code to test and benchmark the above
+int main(int argc, char *argv[]) {
+  int array[] = {2, 3, 4, 10, 10, 10, 40}; // a static array to test the tree on
+  int size = sizeof(array) / sizeof(array[0]); // finding the size of the array
+
+  STree tree(array, size); // build the tree from the array
+
+  std::pair<int, int> range = tree.equalRange(10);
+  std::cout << "Element " << 10 << " found at indices: [" << range.first
+            << ", " << range.second << ")" << std::endl;
+  std::cout << "Lower bound of " << 5 << ": " << tree.lowerBound(5)
+            << std::endl;
+  std::cout << "Upper bound of " << 40 << ": " << tree.upperBound(40)
+            << std::endl;
+
+  // BENCHMARK
+  // we search arrays of 1K, 1M and 100M even numbers with random queries, so
+  // about half of the searches are hits and half are misses
+  long maxSize = argc > 1 ? std::atol(argv[1]) : 100000000;
+  long sizes[] = {1000, 1000000, 100000000};
+  const int numQueries = 1000000;
+
+  std::cout << "size\trecursive (ns)\ts-tree (ns)" << std::endl;
+
+  for (long n : sizes) {
+    if (n > maxSize)
+      break;
+
+    std::vector<int> arr(n);
+    for (long i = 0; i < n; i++)
+      arr[i] = 2 * i;
+
+    STree stree(arr.data(), n);
+
+    // generate the queries with a simple xorshift random number generator
+    std::vector<int> queries(numQueries);
+    unsigned long long seed = 88172645463325252ULL;
+    for (int &q : queries) {
+      seed ^= seed << 13;
+      seed ^= seed >> 7;
+      seed ^= seed << 17;
+      q = seed % (2 * n);
+    }
+
+    long long recursiveSum = 0, streeSum = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int q : queries)
+      recursiveSum += binarySearch(arr.data(), 0, n - 1, q);
+    auto middle = std::chrono::steady_clock::now();
+    for (int q : queries)
+      streeSum += stree.search(arr.data(), q);
+    auto finish = std::chrono::steady_clock::now();
+
+    // since all the keys are distinct, both searches must agree exactly
+    if (recursiveSum != streeSum) {
+      std::cout << "Results differ for size " << n << std::endl;
+      return 1;
+    }
+
+    std::cout << n << "\t"
+              << std::chrono::duration<double, std::nano>(middle - begin)
+                         .count() /
+                     numQueries
+              << "\t\t"
+              << std::chrono::duration<double, std::nano>(finish - middle)
+                         .count() /
+                     numQueries
+              << std::endl;
+  }
+
+  return 0;
+}
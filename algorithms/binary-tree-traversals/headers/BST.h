@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
+#include <vector>
 
 class BST;
 
@@ -7,72 +10,251 @@ BST *minValueNode(BST *node);
 class BST {
 public:
   int data;
-  BST *left, *right;
+  BST *left = nullptr, *right = nullptr;
+  BST *parent = nullptr;
+
+  static const size_t BATCH_LANES = 16;
 
   BST(int data) { this->data = data; }
 
-  void inOrderTraversal(BST *root) {
-    if (root) {
-      inOrderTraversal(root->left);
-      std::cout << root->data << std::endl;
-      inOrderTraversal(root->right);
+  class Iterator {
+  public:
+    BST *node;
+
+    bool valid() { return this->node != nullptr; }
+
+    int key() { return this->node->data; }
+
+    void next() { this->node = successor(this->node); }
+
+    void prev() { this->node = predecessor(this->node); }
+  };
+
+  static BST *successor(BST *node) {
+    if (node->right)
+      return minValueNode(node->right);
+
+    while (node->parent && node == node->parent->right)
+      node = node->parent;
+
+    return node->parent;
+  }
+
+  static BST *predecessor(BST *node) {
+    if (node->left) {
+      node = node->left;
+      while (node->right)
+        node = node->right;
+      return node;
     }
+
+    while (node->parent && node == node->parent->left)
+      node = node->parent;
+
+    return node->parent;
+  }
+
+  Iterator begin(BST *root) { return Iterator{minValueNode(root)}; }
+
+  Iterator last(BST *root) {
+    while (root && root->right)
+      root = root->right;
+
+    return Iterator{root};
+  }
+
+  Iterator lowerBound(BST *root, int key) {
+    BST *candidate = nullptr;
+
+    while (root) {
+      if (root->data >= key) {
+        candidate = root;
+        root = root->left;
+      } else {
+        root = root->right;
+      }
+    }
+
+    return Iterator{candidate};
+  }
+
+  template <typename Callback>
+  void scan(BST *root, int lo, int hi, Callback callback) {
+    for (Iterator it = lowerBound(root, lo); it.valid() && it.key() <= hi;
+         it.next())
+      callback(it.key());
+  }
+
+  void inOrderTraversal(BST *root) {
+    for (Iterator it = begin(root); it.valid(); it.next())
+      std::cout << it.key() << std::endl;
   }
 
   BST *search(BST *root, int key) {
-    if (!root || root->data == key)
-      return root;
+    while (root && root->data != key)
+      root = root->data < key ? root->right : root->left;
+
+    return root;
+  }
+
+  void searchBatch(BST *root, const int *keys, size_t n, BST **results) {
+    BST *node[BATCH_LANES];
+    size_t query[BATCH_LANES];
+    size_t active = 0;
+    size_t next = 0;
+
+    for (; active < BATCH_LANES && next < n; active++, next++) {
+      node[active] = root;
+      query[active] = next;
+    }
+
+    while (active > 0) {
+      for (size_t lane = 0; lane < active;) {
+        BST *current = node[lane];
+        int key = keys[query[lane]];
+
+        if (!current || current->data == key) {
+          results[query[lane]] = current;
 
-    if (root->data < key)
-      return search(root->right, key);
+          if (next < n) {
+            node[lane] = root;
+            query[lane] = next++;
+            lane++;
+          } else {
+            active--;
+            node[lane] = node[active];
+            query[lane] = query[active];
+          }
+          continue;
+        }
 
-    return search(root->left, key);
+        current = current->data < key ? current->right : current->left;
+        __builtin_prefetch(current);
+        node[lane] = current;
+        lane++;
+      }
+    }
   }
 
   BST *insert(BST *root, int key) {
+    BST **link = &root;
+    BST *parent = nullptr;
 
-    if (!root)
-      return new BST(key);
+    while (*link) {
+      parent = *link;
+      link = key > parent->data ? &parent->right : &parent->left;
+    }
 
-    if (key > root->data)
-      root->right = insert(root->right, key);
-    else
-      root->left = insert(root->left, key);
+    *link = new BST(key);
+    (*link)->parent = parent;
 
     return root;
   }
 
-  BST *deleteNode(BST *root, int key) {
-    if (!root) {
-      return root;
-    }
+  BST *deleteNode(BST *root, int key, bool *removed = nullptr) {
+    BST **link = &root;
+
+    if (removed)
+      *removed = false;
+
+    while (*link) {
+      BST *node = *link;
 
-    if (root->data > key) {
-      root->left = deleteNode(root->left, key);
-      return root;
-    } else if (root->data < key) {
-      root->right = deleteNode(root->right, key);
-      return root;
-    } else {
-      if (!root->left && !root->right)
-        return nullptr;
-      else if (!root->left) {
-        BST *temp = root->right;
-        delete root;
-        return temp;
-      } else if (!root->right) {
-        BST *temp = root->left;
-        delete root;
-        return temp;
+      if (node->data > key) {
+        link = &node->left;
+      } else if (node->data < key) {
+        link = &node->right;
+      } else {
+        if (!node->left || !node->right) {
+          *link = node->left ? node->left : node->right;
+          if (*link)
+            (*link)->parent = node->parent;
+          delete node;
+          if (removed)
+            *removed = true;
+          break;
+        }
+
+        BST *temp = minValueNode(node->right);
+
+        node->data = temp->data;
+
+        key = temp->data;
+        link = &node->right;
       }
+    }
+
+    return root;
+  }
+
+  static BST *buildFromSorted(const int *keys, size_t n) {
+    if (n == 0)
+      return nullptr;
 
-      BST *temp = minValueNode(root->right);
+    size_t mid = n / 2;
 
-      root->data = temp->data;
+    BST *root = new BST(keys[mid]);
+    root->left = buildFromSorted(keys, mid);
+    root->right = buildFromSorted(keys + mid + 1, n - mid - 1);
 
-      root->right = deleteNode(root->right, temp->data);
+    if (root->left)
+      root->left->parent = root;
+    if (root->right)
+      root->right->parent = root;
+
+    return root;
+  }
+
+  BST *bulkInsert(BST *root, const int *keys, size_t n) {
+    std::vector<int> batch(keys, keys + n);
+    std::sort(batch.begin(), batch.end());
+
+    std::vector<BST *> nodes;
+    std::vector<int> existing;
+    std::vector<BST *> stack;
+    BST *current = root;
+
+    while (current || !stack.empty()) {
+      while (current) {
+        stack.push_back(current);
+        current = current->left;
+      }
+
+      current = stack.back();
+      stack.pop_back();
+      nodes.push_back(current);
+      existing.push_back(current->data);
+      current = current->right;
     }
 
+    std::vector<int> merged(existing.size() + batch.size());
+    std::merge(existing.begin(), existing.end(), batch.begin(), batch.end(),
+               merged.begin());
+
+    for (size_t i = 0; i < n; i++)
+      nodes.push_back(new BST(0));
+    for (size_t i = 0; i < nodes.size(); i++)
+      nodes[i]->data = merged[i];
+
+    return linkBalanced(nodes.data(), nodes.size());
+  }
+
+  static BST *linkBalanced(BST **nodes, size_t n) {
+    if (n == 0)
+      return nullptr;
+
+    size_t mid = n / 2;
+    BST *root = nodes[mid];
+
+    root->left = linkBalanced(nodes, mid);
+    root->right = linkBalanced(nodes + mid + 1, n - mid - 1);
+
+    root->parent = nullptr;
+    if (root->left)
+      root->left->parent = root;
+    if (root->right)
+      root->right->parent = root;
+
     return root;
   }
 };
@@ -0,0 +1,327 @@
+// This document contains an implementation of a binary search tree whose nodes
+// are stored in an arena (one big contiguous array) instead of being allocated
+// one at a time with new, along with a benchmark comparing it to the regular
+// binary search tree in binary-search-trees.cpp.
+
+// Definition of an arena (also called a region or a memory pool): an arena is
+// a big block of memory that objects are carved out of one after another. All
+// the objects in an arena are freed at the same time, by freeing the arena.
+
+// Every node of the regular binary search tree is a separate new BST(key).
+// That has three costs:
+//    1. every insert calls the memory allocator, which is much slower than
+//    just taking the next free slot in an array
+//    2. the nodes end up scattered all over the heap, so walking down the tree
+//    jumps between unrelated cache lines
+//    3. each node holds an int and three 8 byte pointers (the two children
+//    and the parent), which with padding takes 32 bytes, so only 2 nodes fit
+//    in a 64 byte cache line
+
+// In the arena tree, every node lives in one array, and the children are
+// stored as 32 bit indices into that array instead of pointers. A node is then
+// just 12 bytes (5 nodes per cache line), inserting is just taking the next
+// slot, and tearing down the whole tree is freeing one array. Index 0 is never
+// used for a real node, so it plays the role of nullptr.
+
+// When a node is deleted, its slot is put on a free list (a linked list of
+// free slots, chained through their left index), and the next insert reuses
+// it before taking a new slot from the end of the array.
+
+// Apart from that, the tree works exactly like the regular binary search tree
+// (including sending equal keys to the left subtree), and all the operations
+// take O(h) time, where h is the height of the tree.
+
+#include "../../algorithms/binary-tree-traversals/headers/BST.h" // the regular binary search tree, to compare against
+#include <algorithm> // for max
+#include <chrono>    // for timing the benchmark
+#include <cstdint>   // for uint32_t
+#include <cstdlib>   // for atol
+#include <iostream>  // basic input and output
+#include <random>    // for generating random keys
+#include <vector>    // to be able to use vectors
+
+// this function is declared in the BST header file and is used by the BST
+// class
+BST *minValueNode(BST *node) {
+  BST *current = node;
+
+  while (current && current->left)
+    current = current->left;
+
+  return current;
+}
+
+// this class represents the arena backed binary search tree. It contains
+// functions to search, insert and delete keys, print the tree using an inorder
+// traversal, reserve space for nodes, and remove every node at once
+class ArenaBST {
+private:
+  // a node of the tree. The children are indices into the nodes array
+  struct Node {
+    int data;
+    uint32_t left, right;
+  };
+
+  static const uint32_t NIL = 0; // the index that means "no node"
+
+  std::vector<Node> nodes; // the arena (nodes[0] is never used)
+  uint32_t root = NIL;     // the index of the root node
+  uint32_t freeList = NIL; // the first free slot that can be reused
+  uint32_t count = 0;      // the number of keys in the tree
+
+  // this function will take a key and return the index of a new node holding
+  // the key, reusing a free slot if there is one
+  uint32_t allocate(int key) {
+    uint32_t index;
+
+    if (this->freeList != NIL) {
+      // take the first slot off the free list
+      index = this->freeList;
+      this->freeList = this->nodes[index].left;
+    } else {
+      // take a new slot from the end of the arena
+      index = this->nodes.size();
+      this->nodes.push_back(Node());
+    }
+
+    this->nodes[index] = {key, NIL, NIL};
+    return index;
+  }
+
+  // this function will take the index of a node and put its slot on the free
+  // list so it can be reused
+  void release(uint32_t index) {
+    this->nodes[index].left = this->freeList;
+    this->freeList = index;
+  }
+
+public:
+  // constructor that creates an empty tree
+  ArenaBST() { this->nodes.push_back(Node()); } // slot 0 is the NIL slot
+
+  // this function will take a number of keys and make room in the arena for
+  // that many nodes, so inserting them never has to grow the arena
+  void reserve(uint32_t n) { this->nodes.reserve(n + 1); }
+
+  // this function will take a key and return true if a node with that key is
+  // in the tree, else false
+  bool search(int key) {
+    // the strategy is the same as searching the regular binary search tree,
+    // except that we follow indices instead of pointers
+    uint32_t current = this->root;
+
+    while (current != NIL && this->nodes[current].data != key)
+      current = this->nodes[current].data < key ? this->nodes[current].right
+                                                : this->nodes[current].left;
+
+    return current != NIL;
+  }
+
+  // this function will take a key and insert a node with that key into the
+  // tree
+  void insert(int key) {
+    // the strategy is the same as inserting into the regular binary search
+    // tree: walk down to an empty child, keeping track of the link (the index
+    // variable) that points at the current node, and point it at the new node.
+    // The new node has to be allocated before we take the address of a link,
+    // since allocating can grow (and move) the arena
+
+    uint32_t node = allocate(key);
+    uint32_t *link = &this->root;
+
+    while (*link != NIL) {
+      Node &current = this->nodes[*link];
+      link = key > current.data ? &current.right : &current.left;
+    }
+
+    *link = node;
+    this->count++;
+  }
+
+  // this function will take a key and delete the first occurence of a node
+  // with that key from the tree
+  void deleteNode(int key) {
+    // the strategy is the same as deleting from the regular binary search tree
+    // (see binary-search-trees.cpp for the three cases), except the deleted
+    // slot goes on the free list instead of being freed
+
+    uint32_t *link = &this->root;
+
+    while (*link != NIL) {
+      uint32_t index = *link;
+      Node &node = this->nodes[index];
+
+      if (node.data > key) {
+        link = &node.left;
+      } else if (node.data < key) {
+        link = &node.right;
+      } else {
+        // if the node has at most one child, replace it with that child
+        if (node.left == NIL || node.right == NIL) {
+          *link = node.left != NIL ? node.left : node.right;
+          release(index);
+          this->count--;
+          return;
+        }
+
+        // if both child nodes exist, copy the inorder successor's data into
+        // this node and delete the inorder successor from the right subtree
+        uint32_t successor = node.right;
+        while (this->nodes[successor].left != NIL)
+          successor = this->nodes[successor].left;
+
+        node.data = this->nodes[successor].data;
+        key = node.data;
+        link = &node.right;
+      }
+    }
+  }
+
+  // this function will conduct an inorder traversal and print out the tree.
+  // It uses a stack instead of recursion so a very tall tree can't overflow
+  // the call stack
+  void inOrderTraversal() {
+    std::vector<uint32_t> stack;
+    uint32_t current = this->root;
+
+    while (current != NIL || !stack.empty()) {
+      // go as far left as possible, remembering the nodes on the way
+      while (current != NIL) {
+        stack.push_back(current);
+        current = this->nodes[current].left;
+      }
+
+      // the last node on the stack is the next one in order
+      current = stack.back();
+      stack.pop_back();
+      std::cout << this->nodes[current].data << std::endl;
+      current = this->nodes[current].right;
+    }
+  }
+
+  // this function will remove every node from the tree at once. Since the
+  // nodes don't own anything, this is O(1): the arena is just emptied (it
+  // keeps its memory, so the next inserts don't need to allocate)
+  void clear() {
+    this->nodes.resize(1);
+    this->root = NIL;
+    this->freeList = NIL;
+    this->count = 0;
+  }
+
+  // this is a utility function that returns the number of keys in the tree
+  uint32_t size() { return this->count; }
+
+  // this is a utility function that returns the size of a node in bytes
+  static size_t nodeSize() { return sizeof(Node); }
+};
+
+// this is a utility function that will take the root of a regular binary
+// search tree and delete every node in it
+void deleteTree(BST *root) {
+  std::vector<BST *> stack;
+  if (root)
+    stack.push_back(root);
+
+  while (!stack.empty()) {
+    BST *node = stack.back();
+    stack.pop_back();
+    if (node->left)
+      stack.push_back(node->left);
+    if (node->right)
+      stack.push_back(node->right);
+    delete node;
+  }
+}
+
+// main function, which is just driver code to test and benchmark the above
+int main(int argc, char *argv[]) {
+  ArenaBST tree; // create a new, empty tree
+
+  // insert some nodes
+  int keys[] = {20, 30, 20, 40, 70, 60, 80};
+  for (int key : keys)
+    tree.insert(key);
+
+  // initial traversal of the tree
+  std::cout << "Inorder traversal of tree:" << std::endl;
+  tree.inOrderTraversal();
+
+  // traversal and printing of the tree after a few deletions
+  tree.deleteNode(20);
+  std::cout << "After deleting 20:" << std::endl;
+  tree.inOrderTraversal();
+
+  tree.deleteNode(30);
+  std::cout << "After deleting 30:" << std::endl;
+  tree.inOrderTraversal();
+
+  // the freed slots are reused by these inserts
+  tree.insert(50);
+  tree.insert(10);
+  std::cout << "After inserting 50 and 10:" << std::endl;
+  tree.inOrderTraversal();
+
+  // BENCHMARK
+  // insert n random keys into both trees, search for all of them, and then
+  // tear the trees down. n can be passed as the first argument
+  int n = std::max(argc > 1 ? (int)std::atol(argv[1]) : 1000000, 1);
+
+  std::vector<int> random(n);
+  std::mt19937 rng(42);
+  for (int &key : random)
+    key = rng();
+
+  std::cout << "node size: BST " << sizeof(BST) << " bytes, arena "
+            << ArenaBST::nodeSize() << " bytes" << std::endl;
+
+  // time the regular binary search tree
+  auto begin = std::chrono::steady_clock::now();
+  BST *bst = new BST(random[0]);
+  for (int i = 1; i < n; i++)
+    bst = bst->insert(bst, random[i]);
+  auto inserted = std::chrono::steady_clock::now();
+  for (int key : random)
+    if (!bst->search(bst, key))
+      return 1;
+  auto searched = std::chrono::steady_clock::now();
+  deleteTree(bst);
+  auto finish = std::chrono::steady_clock::now();
+
+  std::cout << "BST:   insert "
+            << std::chrono::duration<double, std::milli>(inserted - begin)
+                   .count()
+            << " ms, search "
+            << std::chrono::duration<double, std::milli>(searched - inserted)
+                   .count()
+            << " ms, teardown "
+            << std::chrono::duration<double, std::milli>(finish - searched)
+                   .count()
+            << " ms" << std::endl;
+
+  // time the arena binary search tree
+  begin = std::chrono::steady_clock::now();
+  ArenaBST *arena = new ArenaBST();
+  for (int key : random)
+    arena->insert(key);
+  inserted = std::chrono::steady_clock::now();
+  for (int key : random)
+    if (!arena->search(key))
+      return 1;
+  searched = std::chrono::steady_clock::now();
+  delete arena;
+  finish = std::chrono::steady_clock::now();
+
+  std::cout << "Arena: insert "
+            << std::chrono::duration<double, std::milli>(inserted - begin)
+                   .count()
+            << " ms, search "
+            << std::chrono::duration<double, std::milli>(searched - inserted)
+                   .count()
+            << " ms, teardown "
+            << std::chrono::duration<double, std::milli>(finish - searched)
+                   .count()
+            << " ms" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,321 @@
+// This document contains an implementation of an AVL tree, which is a self
+// balancing binary search tree. It has the same insert, search and delete
+// functions as the binary search tree in binary-search-trees.cpp, along with a
+// benchmark comparing the two on sorted, reverse sorted and random inserts.
+
+// Definition of an AVL tree (Wikipedia): an AVL tree (named after inventors
+// Adelson-Velsky and Landis) is a self-balancing binary search tree. In an AVL
+// tree, the heights of the two child subtrees of any node differ by at most
+// one; if at any time they differ by more than one, rebalancing is done to
+// restore this property.
+
+// The regular binary search tree never rebalances, so if we insert keys in
+// sorted order, every new key goes to the right of the last one and the tree
+// turns into a linked list with height n. Then every operation takes O(n)
+// time. An AVL tree stores the height of every node, and after every insert or
+// delete it checks the balance factor (the height of the left subtree minus
+// the height of the right subtree) of every node on the way back up. If it is
+// more than 1 or less than -1, it fixes it with rotations (see below). This
+// keeps the height of the tree under 1.44 * log2(n), so search, insert and
+// delete all take O(log(n)) time, no matter the order of the inserts.
+
+// Just like the regular binary search tree, keys that are equal to a node's
+// key are inserted into its left subtree.
+
+#include "../../algorithms/binary-tree-traversals/headers/BST.h" // the regular binary search tree, to compare against
+#include <algorithm> // for max and shuffle
+#include <chrono>    // for timing the benchmark
+#include <cstdlib>   // for atol
+#include <iostream>  // basic input and output
+#include <random>    // for shuffling the random insert order
+#include <vector>    // to be able to use vectors
+
+// this function is declared in the BST header file and is used by the BST
+// class
+BST *minValueNode(BST *node) {
+  BST *current = node;
+
+  while (current && current->left)
+    current = current->left;
+
+  return current;
+}
+
+// just like the BST class, the AVL tree class represents both the tree and
+// each of its nodes. On top of the key and the two children, each node also
+// stores its height (the number of nodes on the longest path from the node
+// down to a leaf)
+class AVLTree {
+public:
+  int data;
+  int height = 1; // a new node is a leaf, so its height is 1
+  AVLTree *left = nullptr, *right = nullptr;
+
+  // constructor for easy creation of an AVL tree (or an AVL tree node)
+  AVLTree(int data) { this->data = data; }
+
+  // this is a utility function that returns the height of a node, which is 0
+  // if the node is null
+  static int heightOf(AVLTree *node) { return node ? node->height : 0; }
+
+  // this is a utility function that recalculates the height of a node from the
+  // heights of its children
+  static void updateHeight(AVLTree *node) {
+    node->height = 1 + std::max(heightOf(node->left), heightOf(node->right));
+  }
+
+  // this is a utility function that returns the balance factor of a node: the
+  // height of its left subtree minus the height of its right subtree
+  static int balanceOf(AVLTree *node) {
+    return heightOf(node->left) - heightOf(node->right);
+  }
+
+  // ROTATIONS
+  // a rotation changes the shape of a tree without changing the order of its
+  // keys. A right rotation around a node y makes its left child x the new root
+  // of the subtree: y becomes x's right child, and x's old right subtree (whose
+  // keys are between x and y) becomes y's left subtree.
+  /*
+           y                x
+          / \              / \
+         x   C    -->     A   y
+        / \                  / \
+       A   B                B   C
+  */
+  // A left rotation is the mirror image of this.
+
+  // this function will take a node y, rotate the subtree rooted at y to the
+  // right and return the new root of the subtree
+  static AVLTree *rotateRight(AVLTree *y) {
+    AVLTree *x = y->left;
+    y->left = x->right;
+    x->right = y;
+
+    // y is now below x, so its height has to be updated first
+    updateHeight(y);
+    updateHeight(x);
+
+    return x;
+  }
+
+  // this function will take a node x, rotate the subtree rooted at x to the
+  // left and return the new root of the subtree
+  static AVLTree *rotateLeft(AVLTree *x) {
+    AVLTree *y = x->right;
+    x->right = y->left;
+    y->left = x;
+
+    // x is now below y, so its height has to be updated first
+    updateHeight(x);
+    updateHeight(y);
+
+    return y;
+  }
+
+  // this function will take the root of a subtree whose children are both
+  // balanced, but whose own balance factor might be off by 2 after an insert or
+  // delete. It fixes the balance with one or two rotations and returns the new
+  // root of the subtree
+  static AVLTree *rebalance(AVLTree *root) {
+    // the strategy is to update the height of the root and check its balance
+    // factor. There are four cases:
+    //    1. left-left: the left subtree is too tall, and so is its left
+    //    subtree. A right rotation around the root fixes it
+    //    2. left-right: the left subtree is too tall, but its right subtree is
+    //    the tall one. A left rotation around the left child turns it into the
+    //    left-left case, and then a right rotation around the root fixes it
+    //    3. right-right: the mirror image of left-left
+    //    4. right-left: the mirror image of left-right
+
+    updateHeight(root);
+    int balance = balanceOf(root);
+
+    if (balance > 1) {
+      if (balanceOf(root->left) < 0)
+        root->left = rotateLeft(root->left); // left-right case
+      return rotateRight(root);              // left-left case
+    }
+
+    if (balance < -1) {
+      if (balanceOf(root->right) > 0)
+        root->right = rotateRight(root->right); // right-left case
+      return rotateLeft(root);                  // right-right case
+    }
+
+    return root; // the subtree is already balanced
+  }
+
+  // function to conduct an inorder traversal and print out the tree
+  void inOrderTraversal(AVLTree *root) {
+    if (root) {
+      inOrderTraversal(root->left);
+      std::cout << root->data << std::endl;
+      inOrderTraversal(root->right);
+    }
+  }
+
+  // this function will take a root node and a key. It will search the tree
+  // for the first occurence of a node with a given key, and return that node
+  // when it is found. If a node with that key is not found, this function
+  // will return nullptr. This is the same as searching a regular binary search
+  // tree, since balancing doesn't change the order of the keys
+  AVLTree *search(AVLTree *root, int key) {
+    while (root && root->data != key)
+      root = root->data < key ? root->right : root->left;
+
+    return root;
+  }
+
+  // this function will take a root node and a key. It will insert a node
+  // with the given key into the tree and return a pointer to the root of the
+  // new (rebalanced) tree
+  AVLTree *insert(AVLTree *root, int key) {
+    // the strategy is the same as inserting into a regular binary search tree,
+    // except that on the way back up, we rebalance every node on the path
+    // from the new node to the root
+
+    if (!root)
+      return new AVLTree(key);
+
+    if (key > root->data)
+      root->right = insert(root->right, key);
+    else
+      root->left = insert(root->left, key);
+
+    return rebalance(root);
+  }
+
+  // this function will take a root node and a key. It will delete the first
+  // occurence of a node in the tree and return the root of the new
+  // (rebalanced) tree
+  AVLTree *deleteNode(AVLTree *root, int key) {
+    // the strategy is the same as deleting from a regular binary search tree
+    // (see binary-search-trees.cpp for the three cases), except that on the
+    // way back up, we rebalance every node on the path to the deleted node
+
+    if (!root)
+      return root;
+
+    if (root->data > key) {
+      root->left = deleteNode(root->left, key);
+    } else if (root->data < key) {
+      root->right = deleteNode(root->right, key);
+    } else {
+      // if the node has at most one child, replace it with that child
+      if (!root->left || !root->right) {
+        AVLTree *child = root->left ? root->left : root->right;
+        delete root;
+        return child;
+      }
+
+      // if both child nodes exist, copy the inorder successor's data into
+      // this node and delete the inorder successor from the right subtree
+      AVLTree *successor = root->right;
+      while (successor->left)
+        successor = successor->left;
+
+      root->data = successor->data;
+      root->right = deleteNode(root->right, successor->data);
+    }
+
+    return rebalance(root);
+  }
+};
+
+// this is a utility function that will take the root of a regular binary
+// search tree and return its height
+int heightOf(BST *root) {
+  // walk the tree level by level, so that a degenerate tree (which is as tall
+  // as it has nodes) doesn't need that many recursive calls
+  int height = 0;
+  std::vector<BST *> level;
+  if (root)
+    level.push_back(root);
+
+  while (!level.empty()) {
+    std::vector<BST *> next;
+    for (BST *node : level) {
+      if (node->left)
+        next.push_back(node->left);
+      if (node->right)
+        next.push_back(node->right);
+    }
+    level.swap(next);
+    height++;
+  }
+
+  return height;
+}
+
+// main function, which is just driver code to test and benchmark the above
+int main(int argc, char *argv[]) {
+  AVLTree *tree = new AVLTree(20); // create a new tree with an initial value
+                                   // of 20
+
+  // insert some nodes (in sorted order, which would make a regular binary
+  // search tree degenerate)
+  tree = tree->insert(tree, 30);
+  tree = tree->insert(tree, 40);
+  tree = tree->insert(tree, 60);
+  tree = tree->insert(tree, 70);
+  tree = tree->insert(tree, 80);
+
+  std::cout << "Inorder traversal of tree (height " << tree->height
+            << "):" << std::endl;
+  tree->inOrderTraversal(tree);
+
+  tree = tree->deleteNode(tree, 20);
+  tree = tree->deleteNode(tree, 30);
+  std::cout << "After deleting 20 and 30 (height " << tree->height
+            << "):" << std::endl;
+  tree->inOrderTraversal(tree);
+
+  // BENCHMARK
+  // insert n keys in sorted, reverse sorted and random order into both trees,
+  // then search for every key. The regular tree takes O(n^2) time to build from
+  // sorted keys, so n is kept small by default (it can be passed as the first
+  // argument)
+  int n = std::max(argc > 1 ? (int)std::atol(argv[1]) : 20000, 1);
+  const char *orders[] = {"sorted", "reverse", "random"};
+
+  std::cout << "order\t\tBST height\tAVL height\tBST (ms)\tAVL (ms)"
+            << std::endl;
+
+  for (int o = 0; o < 3; o++) {
+    std::vector<int> keys(n);
+    for (int i = 0; i < n; i++)
+      keys[i] = o == 1 ? n - i : i;
+    if (o == 2)
+      std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+
+    // time building and searching the regular binary search tree
+    auto begin = std::chrono::steady_clock::now();
+    BST *bst = new BST(keys[0]);
+    for (int i = 1; i < n; i++)
+      bst = bst->insert(bst, keys[i]);
+    for (int key : keys)
+      if (!bst->search(bst, key))
+        return 1;
+    auto middle = std::chrono::steady_clock::now();
+
+    // time building and searching the AVL tree
+    AVLTree *avl = new AVLTree(keys[0]);
+    for (int i = 1; i < n; i++)
+      avl = avl->insert(avl, keys[i]);
+    for (int key : keys)
+      if (!avl->search(avl, key))
+        return 1;
+    auto finish = std::chrono::steady_clock::now();
+
+    std::cout << orders[o] << "\t\t" << heightOf(bst) << "\t\t"
+              << AVLTree::heightOf(avl) << "\t\t"
+              << std::chrono::duration<double, std::milli>(middle - begin)
+                     .count()
+              << "\t\t"
+              << std::chrono::duration<double, std::milli>(finish - middle)
+                     .count()
+              << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,634 @@
+// This document contains an implementation of a B+ tree, which is an ordered
+// set with wide, cache friendly nodes, along with a benchmark comparing it to
+// the regular binary search tree in binary-search-trees.cpp.
+
+// Definition of a B+ tree (Wikipedia): a B+ tree is an m-ary tree with a
+// variable but often large number of children per node. A B+ tree consists of
+// a root, internal nodes and leaves. A B+ tree can be viewed as a B-tree in
+// which each node contains only keys (not key-value pairs), and to which an
+// additional level is added at the bottom with linked leaves.
+
+// Even a perfectly balanced binary search tree has about log2(n) levels, and
+// since the nodes are scattered around memory, every level is usually a cache
+// miss. A B+ tree node holds up to 32 sorted keys (two whole cache lines), so
+// each level narrows the search down 33 ways instead of 2, and the tree only
+// has about log33(n) levels. Inside a node, we find the right key with SIMD
+// (AVX2) comparisons, 8 keys at a time, instead of with a binary search.
+
+// There are two kinds of nodes:
+//    1. inner nodes hold separator keys and pointers to their children. All
+//    the keys in children[i] are less than keys[i], and all the keys in
+//    children[i + 1] are greater than or equal to keys[i]
+//    2. leaves hold the actual keys of the set, and a pointer to the next leaf
+//    in order. All the leaves are at the same depth, so walking the leaves
+//    from left to right visits every key in sorted order (this is what makes
+//    range scans fast)
+
+// Every node except the root is always at least half full. When an insert
+// makes a node overflow, it is split in two and a separator is added to its
+// parent (which can split in turn, all the way up to the root, which is how
+// the tree grows taller). When a delete makes a node less than half full, it
+// borrows a key from a neighbouring sibling, or, if the sibling can't spare
+// one, it is merged with the sibling. This keeps the tree balanced, so search,
+// insert and delete all take O(log(n)) time.
+
+// Unlike the regular binary search tree, this is a set: inserting a key that
+// is already in the tree does nothing.
+
+// compile with g++ -O2 -mavx2 (or -march=native) to use the SIMD node search.
+// The benchmark sizes can be limited by passing the largest size to run as the
+// first argument (default is 100M keys).
+
+#include "../../algorithms/binary-tree-traversals/headers/BST.h" // the regular binary search tree, to compare against
+#include <algorithm> // for shuffle
+#include <chrono>    // for timing the benchmark
+#include <climits>   // for INT_MAX and INT_MIN
+#include <cstdint>   // for uint32_t
+#include <cstdlib>   // for atol
+#include <iostream>  // basic input and output
+#include <random>    // for shuffling the keys
+#include <vector>    // to be able to use vectors
+
+#ifdef __AVX2__
+#include <immintrin.h> // for the AVX2 intrinsics
+#endif
+
+// this function is declared in the BST header file and is used by the BST
+// class
+BST *minValueNode(BST *node) {
+  BST *current = node;
+
+  while (current && current->left)
+    current = current->left;
+
+  return current;
+}
+
+// this class represents the B+ tree. It contains functions to search, insert
+// and delete keys, print the tree in order, and an iterator to walk the keys
+// in order starting from any key
+class BPlusTree {
+private:
+  static const int B = 32;                // the most keys a node can hold
+  static const int MIN_LEAF = B / 2;      // the fewest keys a leaf can hold
+  static const int MIN_INNER = B / 2 - 1; // the fewest keys an inner node has
+
+  // the part shared by both kinds of nodes. The keys come first and are
+  // aligned to a cache line, and the unused ones are always INT_MAX so the
+  // SIMD search can compare all B of them without looking at count
+  struct alignas(64) Node {
+    int keys[B];
+    int count = 0;
+    bool leaf;
+
+    Node(bool leaf) : leaf(leaf) {
+      for (int i = 0; i < B; i++)
+        keys[i] = INT_MAX;
+    }
+  };
+
+  struct Leaf : Node {
+    Leaf *next = nullptr; // the next leaf in order
+
+    Leaf() : Node(true) {}
+  };
+
+  struct Inner : Node {
+    Node *children[B + 1];
+
+    Inner() : Node(false) {}
+  };
+
+  Node *root;
+  long n = 0; // the number of keys in the tree
+
+  // this function will take a node and a value, and return the number of keys
+  // in the node that are less than the value (or less than or equal to it, if
+  // orEqual is true). Since the keys are sorted, this is also the position of
+  // the first key that is not less than (or greater than) the value
+  static int rank(const Node *node, int val, bool orEqual) {
+#ifdef __AVX2__
+    // compare 8 keys at a time with the value, turn the results into a bitmask
+    // and count the set bits. For "less than or equal", count the keys that
+    // are greater and subtract
+    __m256i x = _mm256_set1_epi32(val);
+    int count = 0;
+
+    for (int i = 0; i < B; i += 8) {
+      __m256i k = _mm256_load_si256((const __m256i *)(node->keys + i));
+      __m256i c =
+          orEqual ? _mm256_cmpgt_epi32(k, x) : _mm256_cmpgt_epi32(x, k);
+      count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(c)));
+    }
+
+    // the unused keys are INT_MAX, which are never less than the value, but
+    // can be equal to it, so the result can't be more than count
+    int result = orEqual ? B - count : count;
+    return result < node->count ? result : node->count;
+#else
+    int i = 0;
+    while (i < node->count &&
+           (orEqual ? node->keys[i] <= val : node->keys[i] < val))
+      i++;
+    return i;
+#endif
+  }
+
+  // this function will take a node and make its unused keys INT_MAX again
+  static void pad(Node *node) {
+    for (int i = node->count; i < B; i++)
+      node->keys[i] = INT_MAX;
+  }
+
+  // this function will take a node and a key, and return the leaf whose range
+  // of keys contains the key
+  Leaf *findLeaf(int key) {
+    // at every inner node, go to the child after all the separators that are
+    // less than or equal to the key
+    Node *node = this->root;
+
+    while (!node->leaf)
+      node = ((Inner *)node)->children[rank(node, key, true)];
+
+    return (Leaf *)node;
+  }
+
+  // this function will take a node and a key and insert the key into the
+  // subtree rooted at the node. If the node has to split, the new node (which
+  // holds the upper half) is stored in upNode and the separator between the
+  // two in upKey. It returns false if the key was already in the tree
+  bool insert(Node *node, int key, int &upKey, Node *&upNode) {
+    upNode = nullptr;
+
+    if (node->leaf) {
+      Leaf *leaf = (Leaf *)node;
+      int pos = rank(leaf, key, false);
+
+      if (pos < leaf->count && leaf->keys[pos] == key)
+        return false; // the key is already in the set
+
+      // if the leaf is full, split it in half first. The new leaf gets the
+      // upper half of the keys and goes right after this one
+      if (leaf->count == B) {
+        Leaf *right = new Leaf();
+        right->count = B - B / 2;
+        for (int i = 0; i < right->count; i++)
+          right->keys[i] = leaf->keys[B / 2 + i];
+        leaf->count = B / 2;
+        pad(leaf);
+
+        right->next = leaf->next;
+        leaf->next = right;
+
+        upKey = right->keys[0];
+        upNode = right;
+
+        // the key goes into whichever half it belongs in
+        if (key >= upKey) {
+          leaf = right;
+          pos -= B / 2;
+        }
+      }
+
+      // shift the bigger keys over and put the key in its place
+      for (int i = leaf->count; i > pos; i--)
+        leaf->keys[i] = leaf->keys[i - 1];
+      leaf->keys[pos] = key;
+      leaf->count++;
+
+      return true;
+    }
+
+    Inner *inner = (Inner *)node;
+    int childIndex = rank(inner, key, true);
+    int childUpKey;
+    Node *childUpNode;
+
+    if (!insert(inner->children[childIndex], key, childUpKey, childUpNode))
+      return false;
+
+    if (!childUpNode)
+      return true; // the child didn't split, so there's nothing else to do
+
+    // the child split, so its new sibling needs a separator in this node. If
+    // this node is full, split it first: the middle separator moves up to the
+    // parent, and the new node gets the separators and children after it
+    if (inner->count == B) {
+      Inner *right = new Inner();
+      int mid = B / 2;
+
+      right->count = B - mid - 1;
+      for (int i = 0; i < right->count; i++)
+        right->keys[i] = inner->keys[mid + 1 + i];
+      for (int i = 0; i <= right->count; i++)
+        right->children[i] = inner->children[mid + 1 + i];
+
+      upKey = inner->keys[mid];
+      upNode = right;
+      inner->count = mid;
+      pad(inner);
+
+      // the separator goes into whichever half it belongs in
+      if (childUpKey >= upKey)
+        inner = right;
+      childIndex = rank(inner, childUpKey, true);
+    }
+
+    // shift the bigger separators and their children over, and put the new
+    // separator and child in their place
+    for (int i = inner->count; i > childIndex; i--) {
+      inner->keys[i] = inner->keys[i - 1];
+      inner->children[i + 1] = inner->children[i];
+    }
+    inner->keys[childIndex] = childUpKey;
+    inner->children[childIndex + 1] = childUpNode;
+    inner->count++;
+
+    return true;
+  }
+
+  // this function will take an inner node and the position of one of its
+  // children that has too few keys, and fix it by borrowing a key from a
+  // sibling or merging it with a sibling
+  void fixUnderflow(Inner *parent, int i) {
+    Node *child = parent->children[i];
+    Node *left = i > 0 ? parent->children[i - 1] : nullptr;
+    Node *right = i < parent->count ? parent->children[i + 1] : nullptr;
+    int min = child->leaf ? MIN_LEAF : MIN_INNER;
+
+    if (left && left->count > min) {
+      // borrow the last key of the left sibling
+      for (int j = child->count; j > 0; j--)
+        child->keys[j] = child->keys[j - 1];
+
+      if (child->leaf) {
+        child->keys[0] = left->keys[left->count - 1];
+        parent->keys[i - 1] = child->keys[0];
+      } else {
+        // for inner nodes the key rotates through the parent, and the left
+        // sibling's last child moves over with it
+        Inner *c = (Inner *)child, *l = (Inner *)left;
+        for (int j = c->count + 1; j > 0; j--)
+          c->children[j] = c->children[j - 1];
+        c->children[0] = l->children[l->count];
+        c->keys[0] = parent->keys[i - 1];
+        parent->keys[i - 1] = l->keys[l->count - 1];
+      }
+
+      child->count++;
+      left->count--;
+      pad(left);
+    } else if (right && right->count > min) {
+      // borrow the first key of the right sibling
+      if (child->leaf) {
+        child->keys[child->count] = right->keys[0];
+      } else {
+        Inner *c = (Inner *)child, *r = (Inner *)right;
+        c->keys[c->count] = parent->keys[i];
+        c->children[c->count + 1] = r->children[0];
+        parent->keys[i] = r->keys[0];
+        for (int j = 0; j < r->count; j++)
+          r->children[j] = r->children[j + 1];
+      }
+
+      for (int j = 0; j < right->count - 1; j++)
+        right->keys[j] = right->keys[j + 1];
+      child->count++;
+      right->count--;
+      pad(right);
+
+      if (child->leaf)
+        parent->keys[i] = right->keys[0];
+    } else {
+      // neither sibling can spare a key, so merge the child with one of them.
+      // We always merge the right node of the pair into the left one
+      int li = left ? i - 1 : i; // the position of the left node of the pair
+      Node *a = parent->children[li], *b = parent->children[li + 1];
+
+      if (a->leaf) {
+        for (int j = 0; j < b->count; j++)
+          a->keys[a->count + j] = b->keys[j];
+        a->count += b->count;
+        ((Leaf *)a)->next = ((Leaf *)b)->next;
+      } else {
+        // the separator between the two comes down from the parent
+        Inner *ia = (Inner *)a, *ib = (Inner *)b;
+        ia->keys[ia->count] = parent->keys[li];
+        for (int j = 0; j < ib->count; j++)
+          ia->keys[ia->count + 1 + j] = ib->keys[j];
+        for (int j = 0; j <= ib->count; j++)
+          ia->children[ia->count + 1 + j] = ib->children[j];
+        ia->count += ib->count + 1;
+      }
+
+      // remove the separator and the right node from the parent
+      for (int j = li; j < parent->count - 1; j++) {
+        parent->keys[j] = parent->keys[j + 1];
+        parent->children[j + 1] = parent->children[j + 2];
+      }
+      parent->count--;
+      pad(parent);
+
+      if (b->leaf)
+        delete (Leaf *)b;
+      else
+        delete (Inner *)b;
+    }
+  }
+
+  // this function will take a node and a key, and remove the key from the
+  // subtree rooted at the node. It returns false if the key wasn't there
+  bool remove(Node *node, int key) {
+    if (node->leaf) {
+      int pos = rank(node, key, false);
+
+      if (pos == node->count || node->keys[pos] != key)
+        return false;
+
+      for (int i = pos; i < node->count - 1; i++)
+        node->keys[i] = node->keys[i + 1];
+      node->count--;
+      pad(node);
+
+      return true;
+    }
+
+    Inner *inner = (Inner *)node;
+    int i = rank(inner, key, true);
+
+    if (!remove(inner->children[i], key))
+      return false;
+
+    // if the child is now less than half full, fix it
+    Node *child = inner->children[i];
+    if (child->count < (child->leaf ? MIN_LEAF : MIN_INNER))
+      fixUnderflow(inner, i);
+
+    return true;
+  }
+
+  // this function will take a node and delete it and everything below it
+  static void destroy(Node *node) {
+    if (node->leaf) {
+      delete (Leaf *)node;
+    } else {
+      Inner *inner = (Inner *)node;
+      for (int i = 0; i <= inner->count; i++)
+        destroy(inner->children[i]);
+      delete inner;
+    }
+  }
+
+public:
+  // an iterator over the keys of the tree in sorted order. It walks along the
+  // leaves using their next pointers, so moving to the next key is O(1)
+  class Iterator {
+  public:
+    Leaf *leaf;
+    int pos;
+
+    // this function returns true if the iterator points at a key
+    bool valid() { return this->leaf != nullptr; }
+
+    // this function returns the key the iterator points at
+    int key() { return this->leaf->keys[this->pos]; }
+
+    // this function moves the iterator to the next key in order
+    void next() {
+      if (++this->pos == this->leaf->count) {
+        this->leaf = this->leaf->next;
+        this->pos = 0;
+
+        // skip over any empty leaves (only the root can be an empty leaf)
+        while (this->leaf && this->leaf->count == 0)
+          this->leaf = this->leaf->next;
+      }
+    }
+  };
+
+  // constructor that creates an empty tree (a single empty leaf)
+  BPlusTree() { this->root = new Leaf(); }
+
+  ~BPlusTree() { destroy(this->root); }
+
+  // this function will take a key and return true if it is in the tree, else
+  // false
+  bool search(int key) {
+    Leaf *leaf = findLeaf(key);
+    int pos = rank(leaf, key, false);
+    return pos < leaf->count && leaf->keys[pos] == key;
+  }
+
+  // this function will take a key and insert it into the tree. It returns
+  // false if the key was already in the tree
+  bool insert(int key) {
+    int upKey;
+    Node *upNode;
+
+    if (!insert(this->root, key, upKey, upNode))
+      return false;
+
+    // if the root split, make a new root above the two halves
+    if (upNode) {
+      Inner *newRoot = new Inner();
+      newRoot->keys[0] = upKey;
+      newRoot->children[0] = this->root;
+      newRoot->children[1] = upNode;
+      newRoot->count = 1;
+      this->root = newRoot;
+    }
+
+    this->n++;
+    return true;
+  }
+
+  // this function will take a key and delete it from the tree. It returns
+  // false if the key wasn't in the tree
+  bool deleteNode(int key) {
+    if (!remove(this->root, key))
+      return false;
+
+    // if the root is an inner node with no separators left, its only child
+    // becomes the new root (this is how the tree gets shorter)
+    if (!this->root->leaf && this->root->count == 0) {
+      Inner *old = (Inner *)this->root;
+      this->root = old->children[0];
+      delete old;
+    }
+
+    this->n--;
+    return true;
+  }
+
+  // this function will take a key and return an iterator pointing at the
+  // first key in the tree that is not less than it
+  Iterator lowerBound(int key) {
+    Iterator it;
+    it.leaf = findLeaf(key);
+    it.pos = rank(it.leaf, key, false);
+
+    // if every key in this leaf is less than the key, the answer is the first
+    // key of the next leaf
+    if (it.pos == it.leaf->count) {
+      it.pos = it.leaf->count - 1;
+      if (it.leaf->count == 0) {
+        it.leaf = it.leaf->next;
+        it.pos = 0;
+      } else {
+        it.next();
+      }
+    }
+
+    return it;
+  }
+
+  // this function returns an iterator pointing at the smallest key
+  Iterator begin() { return lowerBound(INT_MIN); }
+
+  // this function will print out every key in the tree in order
+  void inOrderTraversal() {
+    for (Iterator it = begin(); it.valid(); it.next())
+      std::cout << it.key() << std::endl;
+  }
+
+  // this is a utility function that returns the number of keys in the tree
+  long size() { return this->n; }
+};
+
+// this is a utility function that will take the root of a regular binary
+// search tree and return the sum of its keys, visiting them in order without
+// recursion (so we can time a full ordered scan of it)
+long long sumInOrder(BST *root) {
+  long long sum = 0;
+  std::vector<BST *> stack;
+  BST *current = root;
+
+  while (current || !stack.empty()) {
+    while (current) {
+      stack.push_back(current);
+      current = current->left;
+    }
+    current = stack.back();
+    stack.pop_back();
+    sum += current->data;
+    current = current->right;
+  }
+
+  return sum;
+}
+
+// this is a utility function that will take the root of a regular binary
+// search tree and delete every node in it
+void deleteTree(BST *root) {
+  std::vector<BST *> stack;
+  if (root)
+    stack.push_back(root);
+
+  while (!stack.empty()) {
+    BST *node = stack.back();
+    stack.pop_back();
+    if (node->left)
+      stack.push_back(node->left);
+    if (node->right)
+      stack.push_back(node->right);
+    delete node;
+  }
+}
+
+// main function, which is just driver code to test and benchmark the above
+int main(int argc, char *argv[]) {
+  BPlusTree tree; // create a new, empty tree
+
+  // insert some keys (20 twice, but the second insert does nothing)
+  int keys[] = {20, 30, 20, 40, 70, 60, 80};
+  for (int key : keys)
+    tree.insert(key);
+
+  std::cout << "Inorder traversal of tree:" << std::endl;
+  tree.inOrderTraversal();
+
+  tree.deleteNode(20);
+  tree.deleteNode(30);
+  std::cout << "After deleting 20 and 30:" << std::endl;
+  tree.inOrderTraversal();
+
+  std::cout << "Keys from 50 up:";
+  for (BPlusTree::Iterator it = tree.lowerBound(50); it.valid(); it.next())
+    std::cout << " " << it.key();
+  std::cout << std::endl;
+
+  // BENCHMARK
+  // insert n distinct keys in random order into both trees, search for every
+  // key, and scan every key in order, for n from 10K to 100M
+  long maxSize = argc > 1 ? std::atol(argv[1]) : 100000000;
+  long sizes[] = {10000, 100000, 1000000, 10000000, 100000000};
+
+  std::cout << "size\t\tBST insert/search/scan (ms)\t"
+            << "B+ tree insert/search/scan (ms)" << std::endl;
+
+  for (long n : sizes) {
+    if (n > maxSize)
+      break;
+
+    // multiplying by an odd number is a one to one mapping of 32 bit numbers,
+    // so this gives n distinct keys, which are then inserted in a random
+    // order and searched for in a different random order
+    std::vector<int> random(n);
+    for (long i = 0; i < n; i++)
+      random[i] = (int)((uint32_t)i * 2654435761u);
+
+    std::mt19937 rng(42);
+    std::shuffle(random.begin(), random.end(), rng);
+    std::vector<int> queries = random;
+    std::shuffle(queries.begin(), queries.end(), rng);
+
+    double times[2][3];
+
+    auto t0 = std::chrono::steady_clock::now();
+    BST *bst = new BST(random[0]);
+    for (long i = 1; i < n; i++)
+      bst = bst->insert(bst, random[i]);
+    auto t1 = std::chrono::steady_clock::now();
+    for (int key : queries)
+      if (!bst->search(bst, key))
+        return 1;
+    auto t2 = std::chrono::steady_clock::now();
+    long long bstSum = sumInOrder(bst);
+    auto t3 = std::chrono::steady_clock::now();
+    deleteTree(bst);
+
+    times[0][0] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    times[0][1] = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    times[0][2] = std::chrono::duration<double, std::milli>(t3 - t2).count();
+
+    t0 = std::chrono::steady_clock::now();
+    BPlusTree *bplus = new BPlusTree();
+    for (int key : random)
+      bplus->insert(key);
+    t1 = std::chrono::steady_clock::now();
+    for (int key : queries)
+      if (!bplus->search(key))
+        return 1;
+    t2 = std::chrono::steady_clock::now();
+    long long bplusSum = 0;
+    for (BPlusTree::Iterator it = bplus->begin(); it.valid(); it.next())
+      bplusSum += it.key();
+    t3 = std::chrono::steady_clock::now();
+    delete bplus;
+
+    times[1][0] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    times[1][1] = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    times[1][2] = std::chrono::duration<double, std::milli>(t3 - t2).count();
+
+    if (bstSum != bplusSum) {
+      std::cout << "Scans differ for size " << n << std::endl;
+      return 1;
+    }
+
+    std::cout << n << "\t\t" << times[0][0] << " / " << times[0][1] << " / "
+              << times[0][2] << "\t\t" << times[1][0] << " / " << times[1][1]
+              << " / " << times[1][2] << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,392 @@
+// This document contains an implementation of a generic binary search tree map,
+// which stores a value (of any type) with every key (of any type), along with
+// a benchmark comparing it to the regular binary search tree in
+// binary-search-trees.cpp with the values kept in a separate hash map.
+
+// The regular binary search tree only stores an int key in each node. To look
+// up data for a key, we'd have to keep the data in a second structure (like a
+// hash map from key to data), so every access costs a search of the tree AND a
+// lookup in the second structure, and every value is copied into it.
+
+// This map stores the key and the value together in the same node, so one
+// search finds both. It is a class template over:
+//    1. K: the type of the keys
+//    2. V: the type of the values. It doesn't have to be copyable: values can
+//    be move-only (like std::unique_ptr), since the map never copies them
+//    3. Compare: how to order keys (std::less<K> by default). If it is a
+//    "transparent" comparator like std::less<>, keys can be looked up with
+//    any type that can be compared with K (like looking up std::string keys
+//    with a const char* or a std::string_view), without making a K first
+//    4. Alloc: the allocator nodes are allocated with (std::allocator by
+//    default), like the standard library containers
+// Entries are built in place inside their node with emplace and try_emplace,
+// so a value is never copied or even moved once it's in the map.
+
+// Keys are unique, like std::map: inserting a key that is already in the map
+// leaves the old entry alone. Just like the regular binary search tree, the
+// tree isn't balanced.
+
+#include "../../algorithms/binary-tree-traversals/headers/BST.h" // the regular binary search tree, to compare against
+#include <algorithm>     // for max
+#include <chrono>        // for timing the benchmark
+#include <cstdlib>       // for atol
+#include <functional>    // for less
+#include <iostream>      // basic input and output
+#include <memory>        // for allocator_traits and unique_ptr
+#include <random>        // for generating random keys
+#include <string>        // for string keys in the demo
+#include <string_view>   // for looking up string keys without making strings
+#include <tuple>         // for forward_as_tuple
+#include <unordered_map> // for the separate hash map the benchmark compares to
+#include <utility>       // for pair, forward and move
+#include <vector>        // to be able to use vectors
+
+// this function is declared in the BST header file and is used by the BST
+// class
+BST *minValueNode(BST *node) {
+  BST *current = node;
+
+  while (current && current->left)
+    current = current->left;
+
+  return current;
+}
+
+// this class represents the map. It contains functions to insert (emplace,
+// try_emplace), find and erase entries, and visit them in order. An entry is
+// a std::pair of a key and its value, just like in std::map
+template <typename K, typename V, typename Compare = std::less<K>,
+          typename Alloc = std::allocator<std::pair<const K, V>>>
+class BSTMap {
+public:
+  using value_type = std::pair<const K, V>;
+
+private:
+  // a node of the tree. Its entry is constructed in place from whatever
+  // arguments it's given
+  struct Node {
+    value_type entry;
+    Node *left = nullptr, *right = nullptr;
+
+    template <typename... Args>
+    Node(Args &&...args) : entry(std::forward<Args>(args)...) {}
+  };
+
+  // the allocator the user gave us allocates entries, so we "rebind" it to
+  // get an allocator of the same kind that allocates whole nodes
+  using NodeAlloc =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+  using NodeTraits = std::allocator_traits<NodeAlloc>;
+
+  Node *root = nullptr;
+  size_t count = 0;
+  Compare less;
+  NodeAlloc alloc;
+
+  // this is a utility function that allocates a node and constructs its entry
+  // from the given arguments. If the constructor throws, the memory is given
+  // back before the exception goes on
+  template <typename... Args> Node *makeNode(Args &&...args) {
+    Node *node = NodeTraits::allocate(this->alloc, 1);
+    try {
+      NodeTraits::construct(this->alloc, node, std::forward<Args>(args)...);
+    } catch (...) {
+      NodeTraits::deallocate(this->alloc, node, 1);
+      throw;
+    }
+    return node;
+  }
+
+  // this is a utility function that destroys a node's entry and gives its
+  // memory back to the allocator
+  void destroyNode(Node *node) {
+    NodeTraits::destroy(this->alloc, node);
+    NodeTraits::deallocate(this->alloc, node, 1);
+  }
+
+  // this function will take a key (of any type the comparator can compare
+  // with K) and search the tree for it. It returns the link (the root pointer,
+  // or a left or right pointer of some node) that points at the node with the
+  // key, or the empty link where a node with the key would go. This is the
+  // only place the tree is searched, so find-or-insert takes one descent
+  template <typename Key> Node **linkFor(const Key &key) {
+    Node **link = &this->root;
+
+    while (*link) {
+      if (this->less(key, (*link)->entry.first))
+        link = &(*link)->left;
+      else if (this->less((*link)->entry.first, key))
+        link = &(*link)->right;
+      else
+        break; // neither is less than the other, so they are equal
+    }
+
+    return link;
+  }
+
+  // this function will take the arguments for the key and for the value (as
+  // in try_emplace below). It finds the key's link, and only if the key isn't
+  // there, builds a new entry in place right at that link
+  template <typename Key, typename... Args>
+  std::pair<value_type *, bool> tryEmplaceAt(Key &&key, Args &&...args) {
+    Node **link = linkFor(key);
+    if (*link)
+      return {&(*link)->entry, false};
+
+    *link = makeNode(std::piecewise_construct,
+                     std::forward_as_tuple(std::forward<Key>(key)),
+                     std::forward_as_tuple(std::forward<Args>(args)...));
+    this->count++;
+    return {&(*link)->entry, true};
+  }
+
+  // this function will take a link found by linkFor, and delete the entry
+  // it points at (if there is one). It returns true if there was one
+  bool eraseAt(Node **link) {
+    Node *node = *link;
+    if (!node)
+      return false;
+
+    if (!node->left || !node->right) {
+      // if the node has at most one child, that child takes its place
+      *link = node->left ? node->left : node->right;
+    } else {
+      // if both children exist, the regular binary search tree copies the
+      // inorder successor's key into the node. Keys are const here and values
+      // might not be copyable, so instead we unlink the successor node itself
+      // (it has no left child, so its right child takes its place) and put it
+      // where the deleted node was
+      Node **successorLink = &node->right;
+      while ((*successorLink)->left)
+        successorLink = &(*successorLink)->left;
+
+      Node *successor = *successorLink;
+      *successorLink = successor->right;
+
+      successor->left = node->left;
+      successor->right = node->right;
+      *link = successor;
+    }
+
+    destroyNode(node);
+    this->count--;
+    return true;
+  }
+
+public:
+  // constructor that creates an empty map, with a comparator and an
+  // allocator (which default to new ones)
+  BSTMap(const Compare &less = Compare(), const Alloc &alloc = Alloc())
+      : less(less), alloc(alloc) {}
+
+  // the nodes belong to the map, so it can't be copied (that would need V to
+  // be copyable anyway)
+  BSTMap(const BSTMap &) = delete;
+  BSTMap &operator=(const BSTMap &) = delete;
+
+  ~BSTMap() {
+    // destroy every node, using a stack instead of recursion since the tree
+    // might be very tall
+    std::vector<Node *> stack;
+    if (this->root)
+      stack.push_back(this->root);
+
+    while (!stack.empty()) {
+      Node *node = stack.back();
+      stack.pop_back();
+      if (node->left)
+        stack.push_back(node->left);
+      if (node->right)
+        stack.push_back(node->right);
+      destroyNode(node);
+    }
+  }
+
+  // this function will take a key and the arguments for a value. If the key
+  // isn't in the map, it constructs the value in place from the arguments and
+  // inserts the entry. If the key is already there, nothing happens, and the
+  // arguments aren't even used (so a moved-in value isn't lost). It returns a
+  // pointer to the entry with the key, and true if it was just inserted
+  template <typename... Args>
+  std::pair<value_type *, bool> try_emplace(const K &key, Args &&...args) {
+    return tryEmplaceAt(key, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<value_type *, bool> try_emplace(K &&key, Args &&...args) {
+    return tryEmplaceAt(std::move(key), std::forward<Args>(args)...);
+  }
+
+  // this function will take the arguments for a whole entry (like a key and a
+  // value, or std::piecewise_construct and two tuples) and construct the
+  // entry in place. Unlike try_emplace, it has to build the entry before it
+  // knows the key, so if the key is already in the map the new entry is
+  // destroyed again. It returns the same as try_emplace
+  template <typename... Args>
+  std::pair<value_type *, bool> emplace(Args &&...args) {
+    Node *node = makeNode(std::forward<Args>(args)...);
+    Node **link = linkFor(node->entry.first);
+
+    if (*link) {
+      destroyNode(node);
+      return {&(*link)->entry, false};
+    }
+
+    *link = node;
+    this->count++;
+    return {&node->entry, true};
+  }
+
+  // this function will take a key and return a pointer to the entry with that
+  // key, or nullptr if it isn't in the map
+  value_type *find(const K &key) {
+    Node *node = *linkFor(key);
+    return node ? &node->entry : nullptr;
+  }
+
+  // this is the same as find above, for keys of any other type that can be
+  // compared with K. It's only there if the comparator is transparent (has an
+  // is_transparent type, like std::less<>), the same rule std::map uses
+  template <typename Key, typename C = Compare,
+            typename = typename C::is_transparent>
+  value_type *find(const Key &key) {
+    Node *node = *linkFor(key);
+    return node ? &node->entry : nullptr;
+  }
+
+  // this function will take a key and return a reference to its value,
+  // inserting the key with a default constructed value if it isn't in the map
+  V &operator[](const K &key) { return try_emplace(key).first->second; }
+
+  // this function will take a key and delete the entry with that key from the
+  // map. It returns true if there was such an entry, else false
+  bool erase(const K &key) { return eraseAt(linkFor(key)); }
+
+  // this is the same as erase above, for keys of any other type that can be
+  // compared with K, only if the comparator is transparent (just like find)
+  template <typename Key, typename C = Compare,
+            typename = typename C::is_transparent>
+  bool erase(const Key &key) {
+    return eraseAt(linkFor(key));
+  }
+
+  // this is a utility function that returns the number of entries in the map
+  size_t size() const { return this->count; }
+
+  // this function will call the callback with every entry in the map, in
+  // order of their keys. It uses a stack instead of recursion, so a very tall
+  // tree can't overflow the call stack
+  template <typename Callback> void forEach(Callback callback) {
+    std::vector<Node *> stack;
+    Node *node = this->root;
+
+    while (node || !stack.empty()) {
+      while (node) {
+        stack.push_back(node);
+        node = node->left;
+      }
+
+      node = stack.back();
+      stack.pop_back();
+      callback(node->entry);
+      node = node->right;
+    }
+  }
+};
+
+// a value type for the demo that can be moved but never copied, so the demo
+// wouldn't compile if the map ever copied a value
+struct Account {
+  std::unique_ptr<long> balance;
+
+  Account(long balance) : balance(new long(balance)) {}
+  Account(Account &&) = default;
+  Account(const Account &) = delete;
+};
+
+// main function, which is just driver code to test and benchmark the above
+int main(int argc, char *argv[]) {
+  // a map from names to accounts. std::less<> is transparent, so the map can
+  // be searched with a std::string_view or a string literal directly
+  BSTMap<std::string, Account, std::less<>> accounts;
+
+  accounts.try_emplace("carol", 300); // the Account is built inside the node
+  accounts.try_emplace("alice", 100);
+  accounts.emplace("bob", Account(200)); // the Account is moved in, not copied
+
+  // try_emplace with a key that is already there does nothing
+  bool inserted = accounts.try_emplace("alice", 999).second;
+  std::cout << "Inserting alice again: " << (inserted ? "inserted" : "kept")
+            << std::endl;
+
+  std::string_view name = "bob";
+  *accounts.find(name)->second.balance += 50;
+  accounts.erase("carol");
+
+  std::cout << "Accounts in order:" << std::endl;
+  accounts.forEach([](const std::pair<const std::string, Account> &entry) {
+    std::cout << entry.first << ": " << *entry.second.balance << std::endl;
+  });
+
+  // BENCHMARK
+  // count how many times each key appears in a stream of random keys, which
+  // is a find-or-insert followed by an update for every key in the stream.
+  // The regular tree needs a search (and an insert, which searches again, for
+  // a new key) plus a lookup in a separate hash map holding the counts. The
+  // map does it all with one try_emplace. Both are then checked by looking up
+  // every key again. The length of the stream can be passed as the first
+  // argument
+  long n = std::max(argc > 1 ? std::atol(argv[1]) : 2000000, 1L);
+  const int distinct = std::max(n / 4, 1L);
+
+  std::mt19937 rng(42);
+  std::vector<int> stream(n);
+  for (int &key : stream)
+    key = rng() % distinct;
+
+  auto begin = std::chrono::steady_clock::now();
+  BST *bst = nullptr;
+  std::unordered_map<int, long> counts;
+  for (int key : stream) {
+    if (!bst) {
+      bst = new BST(key);
+      counts.emplace(key, 0);
+    } else if (!bst->search(bst, key)) {
+      bst = bst->insert(bst, key);
+      counts.emplace(key, 0);
+    }
+    counts.find(key)->second++;
+  }
+
+  long bstTotal = 0;
+  for (int key = 0; key < distinct; key++)
+    if (bst->search(bst, key))
+      bstTotal += counts.find(key)->second;
+  auto middle = std::chrono::steady_clock::now();
+
+  BSTMap<int, long> map;
+  for (int key : stream)
+    map.try_emplace(key, 0).first->second++;
+
+  long mapTotal = 0;
+  for (int key = 0; key < distinct; key++)
+    if (std::pair<const int, long> *entry = map.find(key))
+      mapTotal += entry->second;
+  auto finish = std::chrono::steady_clock::now();
+
+  // every key in the stream must be counted
+  if (bstTotal != n || mapTotal != n || map.size() != counts.size()) {
+    std::cout << "The counts are wrong" << std::endl;
+    return 1;
+  }
+
+  std::cout << n << " keys (" << map.size() << " distinct): BST + hash map "
+            << std::chrono::duration<double, std::milli>(middle - begin)
+                   .count()
+            << " ms, BSTMap "
+            << std::chrono::duration<double, std::milli>(finish - middle)
+                   .count()
+            << " ms" << std::endl;
+
+  return 0;
+}
@@ -17,13 +17,31 @@
 // class for a node. Instead we can just use a single binary search tree class
 // In this class we'll define a constructor, a search method, an insert method
 // and a delete method. We'll also include a utility function to print the
-// binary search tree using inorder traversal.
+// binary search tree using inorder traversal, methods to build a balanced
+// tree from sorted keys and to insert a whole batch of keys at once, and an
+// iterator to walk the keys in order (forwards or backwards) along with a
+// function to scan all the keys in a range, and a function to search for a
+// whole batch of keys at once.
+
+// every node also keeps a pointer to its parent. That's what lets the
+// iterator move to the next (or previous) key without recursion and without
+// keeping a stack of the nodes above it.
 
 // for all methods in this data structure, the worst case time complexity is
 // O(n). In general though, the worst case time complexity is O(h) where h
-// is the height of the tree.
-
-#include <iostream> // basic input and output
+// is the height of the tree. The bulk methods (buildFromSorted and bulkInsert)
+// always produce a perfectly balanced tree, with height O(log(n)). Moving an
+// iterator to the next key is O(h) in the worst case, but walking over k keys
+// in a row only takes O(h + k) time, since every link is followed at most
+// twice.
+
+#include <algorithm> // for sort, merge and max
+#include <chrono>    // for timing the batched search
+#include <cstddef>   // for size_t
+#include <cstdlib>   // for atol
+#include <iostream>  // basic input and output
+#include <random>    // for generating random keys
+#include <vector>    // to be able to use vectors
 
 class BST;
 
@@ -32,20 +50,122 @@ BST *minValueNode(BST *node);
 class BST {
 public:
   int data;
-  BST *left, *right;
+  BST *left = nullptr, *right = nullptr;
+  BST *parent = nullptr; // null for the root
+
+  // the number of searches searchBatch runs at the same time. This should be
+  // around the number of cache misses the CPU can have in flight at once
+  static const size_t BATCH_LANES = 16;
 
   // constructor for easy creation of a BST (or a BST node)
   BST(int data) { this->data = data; }
 
+  // an iterator over the keys of the tree in sorted order. It just points at
+  // a node, and uses the parent pointers to move to the next or previous node,
+  // so it never allocates anything. Once it moves past either end of the tree
+  // it points at nothing and is no longer valid
+  class Iterator {
+  public:
+    BST *node;
+
+    // this function returns true if the iterator points at a key
+    bool valid() { return this->node != nullptr; }
+
+    // this function returns the key the iterator points at
+    int key() { return this->node->data; }
+
+    // this function moves the iterator to the next key in order
+    void next() { this->node = successor(this->node); }
+
+    // this function moves the iterator to the previous key in order
+    void prev() { this->node = predecessor(this->node); }
+  };
+
+  // this function will take a node and return the node that comes after it in
+  // an inorder traversal, or nullptr if it is the last one
+  static BST *successor(BST *node) {
+    // if the node has a right subtree, the next node is the smallest node in
+    // it. Else, we climb up until we come up from a left child: that parent
+    // is the next node (if we never do, the node was the last one)
+    if (node->right)
+      return minValueNode(node->right);
+
+    while (node->parent && node == node->parent->right)
+      node = node->parent;
+
+    return node->parent;
+  }
+
+  // this function will take a node and return the node that comes before it
+  // in an inorder traversal, or nullptr if it is the first one. This is the
+  // mirror image of successor
+  static BST *predecessor(BST *node) {
+    if (node->left) {
+      node = node->left;
+      while (node->right)
+        node = node->right;
+      return node;
+    }
+
+    while (node->parent && node == node->parent->left)
+      node = node->parent;
+
+    return node->parent;
+  }
+
+  // this function will take a root node and return an iterator pointing at
+  // the smallest key
+  Iterator begin(BST *root) { return Iterator{minValueNode(root)}; }
+
+  // this function will take a root node and return an iterator pointing at
+  // the largest key, to walk the tree backwards
+  Iterator last(BST *root) {
+    while (root && root->right)
+      root = root->right;
+
+    return Iterator{root};
+  }
+
+  // this function will take a root node and a key, and return an iterator
+  // pointing at the first key in order that is not less than the given key
+  // (which isn't valid if there is no such key)
+  Iterator lowerBound(BST *root, int key) {
+    // the strategy is to walk down the tree like search does. Every node that
+    // is not less than the key might be the answer, so we remember it and go
+    // left to look for an earlier one. Every node that is less than the key
+    // isn't, so we go right. The last node we remembered is the answer
+    BST *candidate = nullptr;
+
+    while (root) {
+      if (root->data >= key) {
+        candidate = root;
+        root = root->left;
+      } else {
+        root = root->right;
+      }
+    }
+
+    return Iterator{candidate};
+  }
+
+  // this function will take a root node, two keys lo and hi, and a callback.
+  // It will call the callback with every key in the tree between lo and hi
+  // (both included), in order. Finding lo takes O(h) time, and after that
+  // every key costs O(1) on average
+  template <typename Callback>
+  void scan(BST *root, int lo, int hi, Callback callback) {
+    for (Iterator it = lowerBound(root, lo); it.valid() && it.key() <= hi;
+         it.next())
+      callback(it.key());
+  }
+
   // function to conduct an inorder traversal and print out the tree. For
   // more detail on inorder traversals, see the algorithms section of this
-  // repo where this will be covered
+  // repo where this will be covered. This uses the iterator, so a very tall
+  // tree can't overflow the call stack
   void inOrderTraversal(BST *root) {
-    if (root) {
-      inOrderTraversal(root->left);
-      std::cout << root->data << std::endl;
-      inOrderTraversal(root->right);
-    }
+    for (Iterator it = begin(root); it.valid(); it.next())
+      std::cout << it.key() << std::endl;
   }
 
   // this function will take a root node and a key. It will search the tree
@@ -57,60 +177,126 @@ public:
     // the node we're looking for or if it is nothing return the node (therefore
     // fulfulling the return conditions of this function). If it is not the
     // node, check if the key of the root is less than the desired key,
-    // and recurse right if so. Else recuse left.
+    // and move right if so. Else move left. Repeat until one of the return
+    // conditions is met. This is done with a loop instead of recursion, so
+    // searching a very tall tree can't overflow the stack.
+
+    // keep moving down until the current node is the node we're looking for
+    // or is nullptr
+    while (root && root->data != key) {
+      // if the key is greater than the current node's key, move right, else
+      // move left
+      root = root->data < key ? root->right : root->left;
+    }
 
-    // base case: the root is the node we're looking for or is nullptr
-    if (!root || root->data == key)
-      return root;
+    return root;
+  }
 
-    // if the key is greater than the root's key, recurse right
-    if (root->data < key)
-      return search(root->right, key);
+  // this function will take a root node, a pointer to an array of n keys and
+  // an output array of size n. For every key, it stores the node that search
+  // would return for it (the first occurence of the key, or nullptr) in the
+  // output array. It gives the same answers as calling search once per key,
+  // but is faster for big trees
+  void searchBatch(BST *root, const int *keys, size_t n, BST **results) {
+    // every step of a search has to wait for the next node to come from
+    // memory, and since the step after that depends on it, the CPU can't do
+    // anything else meanwhile. But steps of different searches don't depend
+    // on each other. So the strategy is to run BATCH_LANES searches at the
+    // same time, taking one step of each in turn, and prefetching the next
+    // node of every search right after its step. By the time we come back to
+    // a search, its node has (hopefully) arrived, and the waits for all the
+    // searches overlap. Searches take different numbers of steps, so as soon
+    // as one finishes, its lane starts on the next key (this is sometimes
+    // called asynchronous memory access chaining, or AMAC)
+
+    BST *node[BATCH_LANES];    // the current node of the search in every lane
+    size_t query[BATCH_LANES]; // the key every lane is searching for
+    size_t active = 0;         // the number of lanes with a search in them
+    size_t next = 0;           // the next key that needs a lane
+
+    // start the first searches
+    for (; active < BATCH_LANES && next < n; active++, next++) {
+      node[active] = root;
+      query[active] = next;
+    }
 
-    // if the key is less than the root's key, recurse left
-    return search(root->left, key);
+    while (active > 0) {
+      for (size_t lane = 0; lane < active;) {
+        BST *current = node[lane];
+        int key = keys[query[lane]];
+
+        // if the search is done, store its answer and start the next key in
+        // this lane. If there are no keys left, move the last lane into this
+        // one (and check it without moving on)
+        if (!current || current->data == key) {
+          results[query[lane]] = current;
+
+          if (next < n) {
+            node[lane] = root;
+            query[lane] = next++;
+            lane++;
+          } else {
+            active--;
+            node[lane] = node[active];
+            query[lane] = query[active];
+          }
+          continue;
+        }
+
+        // take one step, the same way search does, and prefetch the next node
+        current = current->data < key ? current->right : current->left;
+        __builtin_prefetch(current);
+        node[lane] = current;
+        lane++;
+      }
+    }
   }
 
   // this function will take a root node and a key. It will insert a node
   // with the given key into the tree and return a pointer to the root of the
   // new tree
   BST *insert(BST *root, int key) {
-    // the strategy is to first check if the root (current node) exists or not
-    // if not, then we can insert the node at this point. So we just make a new
-    // BST and return a pointer to it. However, if it does exist, we have to
-    // traverse further. So we will first check if the value we want to insert
-    // is greater than the one of the current node. If so, we recurse right
-    // and repeat the process there until we encounter null (handled by base
-    // case). Else we recurse left. After everything is done, we should return
-    // the root node, which will be the root of the new tree (and also the old
-    // tree).
-
-    // base case: root is null, so we make a new BST (node)
-    if (!root)
-      return new BST(key);
-
-    // if the key is greater than the current node's data, recurse right
-    if (key > root->data)
-      root->right = insert(root->right, key);
-    // else recurse left
-    else
-      root->left = insert(root->left, key);
-
-    // once everything is done, return the root node
+    // the strategy is to walk down the tree, going right if the key is
+    // greater than the current node's data and left otherwise, until we reach
+    // a null child. That null child is where the new node goes. Instead of
+    // keeping track of the current node, we keep track of a pointer to the
+    // link that points at it (at first that's the root itself, and after that
+    // it's the left or right pointer of its parent). Once that link is null,
+    // we can just point it at the new node. This way the only pointer we
+    // write is the one to the new node, and we don't need to handle the empty
+    // tree as a special case. We then return the root node, which will be the
+    // root of the new tree (and also the old tree, unless it was empty).
+
+    BST **link = &root;    // the link pointing at the current node
+    BST *parent = nullptr; // the node that link belongs to
+
+    // move down until we find an empty spot. If the key is greater than the
+    // current node's data, move right, else move left
+    while (*link) {
+      parent = *link;
+      link = key > parent->data ? &parent->right : &parent->left;
+    }
+
+    // make a new BST (node) in the empty spot
+    *link = new BST(key);
+    (*link)->parent = parent;
+
     return root;
   }
 
   // this function will take a root node and a key. It will delete the first
-  // occurence of a node in the tree and return the root of the new tree.
-  BST *deleteNode(BST *root, int key) {
-    // the strategy is to first check if the root (current node) is null.
-    // If that's the case, there's nothing to, so we can just return the root.
-    // If it is not null, we have to continue our search or operate on this
-    // node, depending on the situation. If this node is not the node we need
-    // to delete, we will continue to search. We will check if the key is
-    // less than the data in the root. If so, we will recurse left, else right.
-    // If this is the node we need to delete (i.e. the value of the key and the
-    // data inside the node are the same), then we proceed to delete it.
+  // occurence of a node in the tree and return the root of the new tree. If
+  // removed is given, it is set to whether a node was actually deleted (so a
+  // caller doesn't have to search for the key first to find out)
+  BST *deleteNode(BST *root, int key, bool *removed = nullptr) {
+    // the strategy is to walk down the tree looking for the node to delete,
+    // just like in insert we keep track of a pointer to the link that points
+    // at the current node. If the current node is null, there's nothing to
+    // delete. If this node is not the node we need to delete, we will
+    // continue to search. We will check if the key is less than the data in
+    // the node. If so, we will move left, else right. If this is the node we
+    // need to delete (i.e. the value of the key and the data inside the node
+    // are the same), then we proceed to delete it.
 
     // Note: this function uses the delete operator and assumes any objects
     // were allocated memory with the new operator.
@@ -136,55 +322,169 @@ public:
     //    for an example case of how the third option works:
     //      https://inst.eecs.berkeley.edu/~cs61bl/r//cur/binary-search-trees/deletion-bst.html?topic=lab17.topic&step=1&course=
 
-    // base case: root is null (just return the root)
-    if (!root) {
-      return root;
+    BST **link = &root; // the link pointing at the current node
+
+    if (removed)
+      *removed = false;
+
+    // keep going until we run out of nodes (i.e. the key isn't in the tree)
+    while (*link) {
+      BST *node = *link; // the current node
+
+      // same logic as search: if the data in the node is greater than the key,
+      // move left, else move right
+      if (node->data > key) {
+        link = &node->left;
+      } else if (node->data < key) {
+        link = &node->right;
+      } else {
+        // if this node has the same data as the given key, this is what we have
+        // to delete (i.e. check the three scenarios)
+
+        // if the node has no child, or only has one child (right or left is
+        // null), point the link at that child (or at null) and delete the node.
+        // The child's parent becomes the node's parent
+        if (!node->left || !node->right) {
+          *link = node->left ? node->left : node->right;
+          if (*link)
+            (*link)->parent = node->parent;
+          delete node;
+          if (removed)
+            *removed = true;
+          break;
+        }
+
+        // finally, if both child nodes exist. find the inorder sucessor
+        // (smallest in the right subtree), copy it's data to the node, and
+        // delete the inorder successor
+
+        // find the inorder successor (smallest child in right subtree)
+        BST *temp = minValueNode(node->right);
+
+        // copy the inorder successor's content to this node
+        node->data = temp->data;
+
+        // delete the inorder successor, by searching for its data in the right
+        // subtree and continuing the loop from there
+        key = temp->data;
+        link = &node->right;
+      }
     }
 
-    // recursive calls for ancestors of node to be deleted. Same logic: if
-    // the data in the root is greater than the key, recurse left, else recurse
-    // right
-    if (root->data > key) {
-      root->left = deleteNode(root->left, key);
-      return root;
-    } else if (root->data < key) {
-      root->right = deleteNode(root->right, key);
-      return root;
-    } else {
-      // if this node has the same data as the given key, this is what we have
-      // to delete (i.e. check the three scenarios)
-
-      // if the node has no child
-      if (!root->left && !root->right)
-        return nullptr;
-      // if the node only has one child (right or left is null)
-      else if (!root->left) {
-        BST *temp =
-            root->right; // store a temp node as the current root's right child
-        delete root;     // delete the root
-        return temp;     // return the temp node as the root of the new tree
-      } else if (!root->right) {
-        BST *temp =
-            root->left; // store a temp node as the current root's left child
-        delete root;    // delete the root
-        return temp;    // return the temp node as the root of the new tree
-      }
+    // return the root of the new tree
+    return root;
+  }
 
-      // finally, if both child nodes exist. find the inorder sucessor (smallest
-      // in the right subtree), copy it's data to the root, and delete the
-      // inorder successor
+  // this function will take a pointer to a sorted array of keys and the
+  // number of keys, and return the root of a perfectly balanced tree holding
+  // all of them. The time complexity of this function is O(n), compared to
+  // O(n * h) for n calls to insert (which is O(n^2) for sorted keys, since
+  // every key goes to the right of the last one)
+  static BST *buildFromSorted(const int *keys, size_t n) {
+    // the strategy is to make the middle key the root, since half of the keys
+    // are smaller than it and half are bigger. Then the left subtree is built
+    // (the same way) from the keys before the middle, and the right subtree
+    // from the keys after it. Every key is visited once, and each node is
+    // allocated right as it is linked into the tree.
+
+    // Note: if there are duplicate keys, some copies can end up in the right
+    // subtree of an equal key (insert always sends them left). The inorder
+    // traversal is still sorted, so search, insert and deleteNode all still
+    // work.
+
+    // base case: there are no keys, so the tree is empty
+    if (n == 0)
+      return nullptr;
+
+    size_t mid = n / 2; // the position of the middle key
+
+    BST *root = new BST(keys[mid]);
+    root->left = buildFromSorted(keys, mid);
+    root->right = buildFromSorted(keys + mid + 1, n - mid - 1);
+
+    if (root->left)
+      root->left->parent = root;
+    if (root->right)
+      root->right->parent = root;
 
-      // find the inorder successor (smallest child in right subtree)
-      BST *temp = minValueNode(root->right);
+    return root;
+  }
 
-      // copy the inorder successor's content to this node
-      root->data = temp->data;
+  // this function will take a root node, a pointer to an array of keys (in
+  // any order) and the number of keys. It will insert all the keys into the
+  // tree and return a pointer to the root of the new tree, which is perfectly
+  // balanced. The time complexity of this function is O(m * log(m) + n), where
+  // m is the number of new keys and n is the number of nodes already in the
+  // tree
+  BST *bulkInsert(BST *root, const int *keys, size_t n) {
+    // the strategy is to sort the new keys, and then flatten the tree into
+    // its nodes in order (which gives us its keys in sorted order). Then we
+    // merge the two sorted lists of keys (just like in merge sort), make new
+    // nodes for the new keys, and link all the nodes back up into a perfectly
+    // balanced tree (the same way buildFromSorted does). The old nodes are
+    // reused, so only the new keys need new nodes.
+
+    // sort a copy of the new keys
+    std::vector<int> batch(keys, keys + n);
+    std::sort(batch.begin(), batch.end());
+
+    // flatten the tree with an inorder traversal. This uses a stack instead of
+    // recursion so a very tall tree can't overflow the call stack
+    std::vector<BST *> nodes;
+    std::vector<int> existing;
+    std::vector<BST *> stack;
+    BST *current = root;
+
+    while (current || !stack.empty()) {
+      while (current) {
+        stack.push_back(current);
+        current = current->left;
+      }
 
-      // delete the inorder successor
-      root->right = deleteNode(root->right, temp->data);
+      current = stack.back();
+      stack.pop_back();
+      nodes.push_back(current);
+      existing.push_back(current->data);
+      current = current->right;
     }
 
-    // return the root of the new tree
+    // merge the old and new keys into one sorted list
+    std::vector<int> merged(existing.size() + batch.size());
+    std::merge(existing.begin(), existing.end(), batch.begin(), batch.end(),
+               merged.begin());
+
+    // make the new nodes, and give every node its key in sorted order
+    for (size_t i = 0; i < n; i++)
+      nodes.push_back(new BST(0));
+    for (size_t i = 0; i < nodes.size(); i++)
+      nodes[i]->data = merged[i];
+
+    // link the nodes back up into a balanced tree
+    return linkBalanced(nodes.data(), nodes.size());
+  }
+
+  // this is a utility function that will take an array of nodes whose keys are
+  // in sorted order and the number of nodes, link them into a perfectly
+  // balanced tree and return its root
+  static BST *linkBalanced(BST **nodes, size_t n) {
+    // same strategy as buildFromSorted, except the nodes already exist
+    if (n == 0)
+      return nullptr;
+
+    size_t mid = n / 2;
+    BST *root = nodes[mid];
+
+    root->left = linkBalanced(nodes, mid);
+    root->right = linkBalanced(nodes + mid + 1, n - mid - 1);
+
+    // the root has no parent (if it's a subtree, its parent is set by the
+    // call that links it)
+    root->parent = nullptr;
+    if (root->left)
+      root->left->parent = root;
+    if (root->right)
+      root->right->parent = root;
+
     return root;
   }
 };
@@ -232,5 +532,65 @@ int main(int argc, char *argv[]) {
   std::cout << "After deleting 50:" << std::endl;
   tree->inOrderTraversal(tree);
 
+  // insert a batch of unsorted keys at once, which also rebalances the tree
+  int batch[] = {90, 10, 50, 30};
+  tree = tree->bulkInsert(tree, batch, sizeof(batch) / sizeof(batch[0]));
+  std::cout << "After bulk inserting 90, 10, 50 and 30:" << std::endl;
+  tree->inOrderTraversal(tree);
+
+  // build a balanced tree straight from sorted keys
+  int sorted[] = {1, 2, 3, 4, 5, 6, 7};
+  BST *balanced = BST::buildFromSorted(sorted, 7);
+  std::cout << "Root of tree built from 1 to 7: " << balanced->data
+            << std::endl;
+
+  // walk the tree backwards with an iterator
+  std::cout << "Keys in reverse order:";
+  for (BST::Iterator it = tree->last(tree); it.valid(); it.prev())
+    std::cout << " " << it.key();
+  std::cout << std::endl;
+
+  // scan a range of keys, adding them up with a callback
+  int sum = 0;
+  tree->scan(tree, 25, 65, [&sum](int key) { sum += key; });
+  std::cout << "Sum of keys between 25 and 65: " << sum << std::endl;
+
+  // time searching a big tree for a batch of random keys (half of them in the
+  // tree) one at a time, and with searchBatch. n can be passed as the first
+  // argument
+  int n = std::max(argc > 1 ? (int)std::atol(argv[1]) : 1000000, 1);
+  std::mt19937 rng(42);
+
+  BST *big = new BST(rng() % (2 * n));
+  for (int i = 1; i < n; i++)
+    big = big->insert(big, rng() % (2 * n));
+
+  std::vector<int> queries(n);
+  for (int &q : queries)
+    q = rng() % (2 * n);
+
+  std::vector<BST *> oneByOne(n), batched(n);
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < n; i++)
+    oneByOne[i] = big->search(big, queries[i]);
+  auto middle = std::chrono::steady_clock::now();
+  big->searchBatch(big, queries.data(), n, batched.data());
+  auto finish = std::chrono::steady_clock::now();
+
+  // both ways must find exactly the same nodes
+  if (oneByOne != batched) {
+    std::cout << "searchBatch gave different results" << std::endl;
+    return 1;
+  }
+
+  std::cout << "Searching " << n << " keys: one at a time "
+            << std::chrono::duration<double, std::milli>(middle - begin)
+                   .count()
+            << " ms, batched "
+            << std::chrono::duration<double, std::milli>(finish - middle)
+                   .count()
+            << " ms" << std::endl;
+
   return 0;
 } 
@@ -0,0 +1,380 @@
+// This document contains an implementation of a blocked Bloom filter, and a
+// binary search tree that checks it before every search, along with a
+// benchmark comparing it to the regular binary search tree in
+// binary-search-trees.cpp when most searches are for keys that aren't there.
+
+// Definition of a Bloom filter (Wikipedia): a Bloom filter is a space-efficient
+// probabilistic data structure that is used to test whether an element is a
+// member of a set. False positive matches are possible, but false negatives
+// are not - in other words, a query returns either "possibly in set" or
+// "definitely not in set".
+
+// When the key we search for isn't in the tree, the search has to walk all
+// the way down to a null child, and every step is likely a cache miss. A Bloom
+// filter is a big array of bits: adding a key sets k bits chosen by hashing
+// it, and a key can only be in the set if all k of its bits are set. If any of
+// them is 0, we know the key was never added, and we can skip the tree
+// entirely. If all of them are 1 (because of the key itself, or because other
+// keys happened to set them), we search the tree as usual.
+
+// In a regular Bloom filter, the k bits are spread over the whole array, so
+// checking a key costs k cache misses. In a blocked Bloom filter, the array is
+// split into blocks of 512 bits (one 64 byte cache line), the hash picks one
+// block, and all k bits are in that block. So checking a key costs at most
+// one cache miss. Here, k = 8: a block is 8 64 bit words, and every key sets
+// one bit in each word. This makes false positives a little more likely than
+// in a regular Bloom filter with the same number of bits, but it's much faster.
+
+// A Bloom filter can't remove a key, since its bits might also belong to
+// other keys. So when a key is deleted from the tree, its bits just stay set.
+// That never causes a wrong answer (only more false positives), and once
+// enough keys have been deleted, the filter is rebuilt from the keys still in
+// the tree. The filter is sized for an expected number of keys, and it is also
+// rebuilt (twice as big) if the tree grows past that.
+
+// Checking the filter takes O(1) time, and the search itself still takes O(h)
+// time, where h is the height of the tree. A rebuild takes O(n) time.
+
+// The number of keys in the benchmark can be passed as the first argument.
+
+#include "../../algorithms/binary-tree-traversals/headers/BST.h" // the regular binary search tree, to put the filter in front of
+#include <algorithm> // for max
+#include <chrono>    // for timing the benchmark
+#include <cstdint>   // for fixed width integer types
+#include <cstdlib>   // for atol
+#include <iostream>  // basic input and output
+#include <random>    // for generating random keys
+#include <vector>    // to be able to use vectors
+
+// this function is declared in the BST header file and is used by the BST
+// class
+BST *minValueNode(BST *node) {
+  BST *current = node;
+
+  while (current && current->left)
+    current = current->left;
+
+  return current;
+}
+
+// this class represents the blocked Bloom filter. It contains functions to add
+// a key, check whether a key might have been added, empty the filter, and
+// estimate how often it will give a false positive
+class BlockedBloomFilter {
+private:
+  // a block of the filter, which is exactly one cache line
+  struct alignas(64) Block {
+    uint64_t words[8];
+  };
+
+  std::vector<Block> blocks;
+
+  // this function will take a key and return a 64 bit hash of it. This is
+  // the finalizer of the MurmurHash3 hash function, which mixes every bit of
+  // the key into every bit of the hash
+  static uint64_t hash(int key) {
+    uint64_t h = (uint32_t)key;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  // this function will take a hash and return the block it belongs in. It
+  // uses the high 32 bits of the hash, scaled to the number of blocks (which
+  // is faster than taking the remainder)
+  size_t blockOf(uint64_t h) const {
+    return (size_t)(((h >> 32) * this->blocks.size()) >> 32);
+  }
+
+  // this function will take a hash and a word number (0 to 7), and return the
+  // bit of that word the hash sets. Every word multiplies the low 32 bits of
+  // the hash by a different odd number and takes the top 6 bits, so the words
+  // get (nearly) independent bits from one hash
+  static uint64_t bitOf(uint64_t h, int word) {
+    static const uint32_t SALT[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU,
+                                     0xa2b7289dU, 0x705495c7U, 0x2df1424bU,
+                                     0x9efc4947U, 0x5c6bfb31U};
+    return 1ULL << (((uint32_t)h * SALT[word]) >> 26);
+  }
+
+public:
+  // constructor that will take the number of keys the filter is expected to
+  // hold and the number of bits to use per key, and make an empty filter
+  BlockedBloomFilter(size_t expectedKeys = 0, double bitsPerKey = 10) {
+    resize(expectedKeys, bitsPerKey);
+  }
+
+  // this function will take the number of keys the filter is expected to hold
+  // and the number of bits to use per key, and empty the filter and resize it
+  // to fit that many keys
+  void resize(size_t expectedKeys, double bitsPerKey = 10) {
+    size_t numBlocks = (size_t)(expectedKeys * bitsPerKey / 512) + 1;
+    this->blocks.assign(numBlocks, Block());
+  }
+
+  // this function will take a key and add it to the filter
+  void add(int key) {
+    uint64_t h = hash(key);
+    Block &block = this->blocks[blockOf(h)];
+
+    for (int i = 0; i < 8; i++)
+      block.words[i] |= bitOf(h, i);
+  }
+
+  // this function will take a key and return false if it was definitely never
+  // added to the filter, or true if it might have been
+  bool mayContain(int key) const {
+    // check all 8 bits without stopping early, so there are no hard to
+    // predict branches. They are all in the same cache line anyway
+    uint64_t h = hash(key);
+    const Block &block = this->blocks[blockOf(h)];
+    bool all = true;
+
+    for (int i = 0; i < 8; i++)
+      all &= (block.words[i] & bitOf(h, i)) != 0;
+
+    return all;
+  }
+
+  // this function will empty the filter, keeping its size
+  void clear() { this->blocks.assign(this->blocks.size(), Block()); }
+
+  // this function returns the chance that checking a key that was never
+  // added gives a false positive, based on how full the filter is right now.
+  // A random key picks a random block, and then a random bit in each word, so
+  // for each block the chance is the product of how full each of its words is
+  double estimatedFalsePositiveRate() const {
+    double total = 0;
+
+    for (const Block &block : this->blocks) {
+      double chance = 1;
+      for (int i = 0; i < 8; i++)
+        chance *= __builtin_popcountll(block.words[i]) / 64.0;
+      total += chance;
+    }
+
+    return total / this->blocks.size();
+  }
+
+  // this is a utility function that returns the size of the filter in bytes
+  size_t bytes() const { return this->blocks.size() * sizeof(Block); }
+};
+
+// counters that BloomFilteredBST keeps about its searches, for tuning the
+// filter
+struct FilterStats {
+  long searches = 0;       // the number of searches
+  long skipped = 0;        // searches the filter answered without the tree
+  long falsePositives = 0; // searches that went to the tree for nothing
+  long rebuilds = 0;       // the number of times the filter was rebuilt
+};
+
+// this class represents a binary search tree with a blocked Bloom filter in
+// front of it. It contains functions to search, insert and delete keys, and
+// to look at how well the filter is working
+class BloomFilteredBST {
+private:
+  BST *root = nullptr;
+  BlockedBloomFilter filter;
+  double bitsPerKey;
+  size_t capacity;        // the number of keys the filter is sized for
+  size_t count = 0;       // the number of keys in the tree
+  size_t staleKeys = 0;   // deleted keys whose bits are still in the filter
+  FilterStats statistics; // see FilterStats
+
+public:
+  // constructor that will take the number of keys the tree is expected to
+  // hold and the number of filter bits to use per key, and make an empty tree
+  BloomFilteredBST(size_t expectedKeys, double bitsPerKey = 10)
+      : filter(expectedKeys, bitsPerKey) {
+    this->bitsPerKey = bitsPerKey;
+    this->capacity = expectedKeys;
+  }
+
+  // this function will take a key and return the first node with that key in
+  // the tree, or nullptr if there isn't one. If the filter says the key is
+  // definitely not in the tree, the tree isn't searched at all
+  BST *search(int key) {
+    this->statistics.searches++;
+
+    if (!this->filter.mayContain(key)) {
+      this->statistics.skipped++;
+      return nullptr;
+    }
+
+    BST *node = this->root ? this->root->search(this->root, key) : nullptr;
+    if (!node)
+      this->statistics.falsePositives++;
+
+    return node;
+  }
+
+  // this function will take a key and insert a node with that key into the
+  // tree, and add the key to the filter
+  void insert(int key) {
+    this->root =
+        this->root ? this->root->insert(this->root, key) : new BST(key);
+    this->count++;
+
+    // if the tree has grown past what the filter was sized for, false
+    // positives would quickly get more common, so make the filter twice as
+    // big (this also adds the new key to it)
+    if (this->count > this->capacity) {
+      this->capacity = 2 * this->count;
+      rebuild();
+    } else {
+      this->filter.add(key);
+    }
+  }
+
+  // this function will take a key and delete the first occurence of a node
+  // with that key from the tree. The key's bits stay in the filter until
+  // enough keys have been deleted to make rebuilding it worth it
+  void deleteNode(int key) {
+    if (!this->root)
+      return;
+
+    bool removed;
+    this->root = this->root->deleteNode(this->root, key, &removed);
+    if (!removed)
+      return;
+
+    this->count--;
+
+    // once a quarter of the filter's capacity is made of deleted keys, rebuild
+    // it from the keys that are left
+    if (++this->staleKeys > this->capacity / 4)
+      rebuild();
+  }
+
+  // this function will empty the filter and add every key still in the tree
+  // to it, using the tree's iterator
+  void rebuild() {
+    this->filter.resize(this->capacity, this->bitsPerKey);
+
+    if (this->root)
+      for (BST::Iterator it = this->root->begin(this->root); it.valid();
+           it.next())
+        this->filter.add(it.key());
+
+    this->staleKeys = 0;
+    this->statistics.rebuilds++;
+  }
+
+  // this function returns the counters about the searches so far
+  FilterStats stats() const { return this->statistics; }
+
+  // this function returns the chance that searching for a key that isn't in
+  // the tree still has to search the tree, based on how full the filter is
+  double estimatedFalsePositiveRate() const {
+    return this->filter.estimatedFalsePositiveRate();
+  }
+
+  // this is a utility function that returns the size of the filter in bytes
+  size_t filterBytes() const { return this->filter.bytes(); }
+
+  // this is a utility function that returns the number of keys in the tree
+  size_t size() const { return this->count; }
+};
+
+// main function, which is just driver code to test and benchmark the above
+int main(int argc, char *argv[]) {
+  BloomFilteredBST tree(100); // create a new, empty tree for about 100 keys
+
+  // insert some nodes
+  int keys[] = {20, 30, 20, 40, 70, 60, 80};
+  for (int key : keys)
+    tree.insert(key);
+
+  std::cout << "Search for 40: " << (tree.search(40) != nullptr) << std::endl;
+  std::cout << "Search for 50: " << (tree.search(50) != nullptr) << std::endl;
+  tree.deleteNode(40);
+  std::cout << "Search for 40 after deleting it: "
+            << (tree.search(40) != nullptr) << std::endl;
+
+  // BENCHMARK
+  // insert n random keys (the even numbers, so every odd number is a miss)
+  // into a regular tree and a filtered tree. Then search both for n keys, 90%
+  // of which aren't in the trees. Then delete half the keys and search again
+  int n = std::max(argc > 1 ? (int)std::atol(argv[1]) : 1000000, 1);
+
+  std::mt19937 rng(42);
+  std::vector<int> inserted(n);
+  for (int &key : inserted)
+    key = 2 * (int)(rng() % n);
+
+  BST *plain = new BST(inserted[0]);
+  BloomFilteredBST filtered(n);
+  filtered.insert(inserted[0]);
+  for (int i = 1; i < n; i++) {
+    plain = plain->insert(plain, inserted[i]);
+    filtered.insert(inserted[i]);
+  }
+
+  std::vector<int> queries(n);
+  for (int &q : queries)
+    q = rng() % 10 == 0 ? inserted[rng() % n] : 2 * (int)(rng() % n) + 1;
+
+  std::cout << "filter: " << (double)filtered.filterBytes() * 8 / n
+            << " bits per key" << std::endl;
+  std::cout << "phase\t\tBST (ns)\tfiltered (ns)\testimated FPR\tmeasured FPR"
+            << std::endl;
+
+  for (int phase = 0; phase < 2; phase++) {
+    if (phase == 1) {
+      // delete every other inserted key from both trees
+      for (int i = 0; i < n; i += 2) {
+        plain = plain->deleteNode(plain, inserted[i]);
+        filtered.deleteNode(inserted[i]);
+      }
+    }
+
+    FilterStats before = filtered.stats();
+    long plainFound = 0, filteredFound = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int q : queries)
+      plainFound += plain && plain->search(plain, q) != nullptr;
+    auto middle = std::chrono::steady_clock::now();
+    for (int q : queries)
+      filteredFound += filtered.search(q) != nullptr;
+    auto finish = std::chrono::steady_clock::now();
+
+    // a Bloom filter never hides a key that is there
+    if (plainFound != filteredFound) {
+      std::cout << "The filtered tree gave different results" << std::endl;
+      return 1;
+    }
+
+    // the measured false positive rate is the fraction of the searches for
+    // missing keys that the filter didn't catch. After the deletes, that
+    // includes the deleted keys whose bits are still set (until the next
+    // rebuild), so it is higher than the estimate, which is only for keys
+    // that were never added
+    FilterStats after = filtered.stats();
+    long misses = (after.skipped - before.skipped) +
+                  (after.falsePositives - before.falsePositives);
+
+    std::cout << (phase == 0 ? "after inserts" : "after deletes") << "\t"
+              << std::chrono::duration<double, std::nano>(middle - begin)
+                         .count() /
+                     n
+              << "\t\t"
+              << std::chrono::duration<double, std::nano>(finish - middle)
+                         .count() /
+                     n
+              << "\t\t" << filtered.estimatedFalsePositiveRate() << "\t"
+              << (misses ? (double)(after.falsePositives -
+                                    before.falsePositives) /
+                               misses
+                         : 0)
+              << std::endl;
+  }
+
+  std::cout << "rebuilds: " << filtered.stats().rebuilds << std::endl;
+
+  return 0;
+}
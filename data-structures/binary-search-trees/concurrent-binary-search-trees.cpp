@@ -0,0 +1,457 @@
+// This document contains an implementation of a binary search tree that many
+// threads can use at the same time, along with a benchmark comparing it to the
+// regular binary search tree in binary-search-trees.cpp protected by a single
+// global mutex.
+
+// The regular binary search tree isn't thread safe at all, so the simplest way
+// to share it between threads is to lock one mutex around every operation.
+// But then only one thread can use the tree at a time, even if all of them are
+// just reading. This tree lets any number of threads read and write it at the
+// same time:
+//    1. searches never take a lock. They just walk down the tree, reading the
+//    child pointers with atomic loads. Since a node's key never changes once
+//    it's in the tree, a reader always sees a consistent node.
+//    2. inserts and deletes first find their spot without taking any locks,
+//    and then lock only the one or two nodes they are about to change (each
+//    node has its own spinlock, a single byte, so a node is only 24 bytes,
+//    smaller than a regular binary search tree node). Since another thread
+//    could have changed those nodes in between, they check (validate) that
+//    the nodes are still what they expected, and if not, they start over.
+//    Locks are always taken from the parent down to the child, so two writers
+//    can never deadlock.
+//    3. the regular deleteNode copies the inorder successor's key into a node
+//    with two children, which would change a key under a reader's feet.
+//    Instead, a node with two children is only marked as deleted, and stays
+//    in the tree as a routing node (its key still guides searches left or
+//    right). Inserting its key again just unmarks it. Nodes with zero or one
+//    child are actually unlinked from the tree. (A marked node stays in the
+//    tree even if it later loses a child, which keeps deletes simple at the
+//    cost of some extra nodes in trees with a lot of deletes.)
+
+// Once a node is unlinked, we can't free it right away, because a reader
+// might still be looking at it. So we use epoch based reclamation: there is a
+// global epoch number, and every thread announces the epoch it saw when it
+// starts an operation. An unlinked node is put on a "limbo" list with the
+// epoch it was unlinked in. The global epoch can only move forward once every
+// thread that is in the middle of an operation has seen the current one. So
+// once the global epoch is two past the node's epoch, every thread that could
+// have seen the node has finished, and it can be freed.
+
+// Like the regular binary search tree, the tree isn't balanced, so every
+// operation takes O(h) time, where h is the height of the tree. Unlike the
+// regular binary search tree, this is a set: inserting a key that is already
+// in the tree does nothing.
+
+// compile with g++ -O2 -pthread. The number of operations per thread can be
+// passed as the first argument.
+
+#include "../../algorithms/binary-tree-traversals/headers/BST.h" // the regular binary search tree, to compare against
+#include <atomic>   // for atomic variables
+#include <chrono>   // for timing the benchmark
+#include <climits>  // for INT_MAX
+#include <cstdlib>  // for atol and abort
+#include <iostream> // basic input and output
+#include <mutex>    // for mutexes and lock_guard
+#include <random>   // for generating random operations
+#include <thread>   // for running threads
+#include <utility>  // for std::pair
+#include <vector>   // to be able to use vectors
+
+// this function is declared in the BST header file and is used by the BST
+// class
+BST *minValueNode(BST *node) {
+  BST *current = node;
+
+  while (current && current->left)
+    current = current->left;
+
+  return current;
+}
+
+// the most threads that can use a ConcurrentBST at the same time
+const int MAX_THREADS = 256;
+
+// the thread indices that are free to be handed out. Indices below next have
+// been handed out before, and the ones in free have been given back
+struct ThreadIndexPool {
+  std::mutex lock;
+  std::vector<int> free;
+  int next = 0;
+};
+
+ThreadIndexPool &threadIndexPool() {
+  static ThreadIndexPool pool;
+  return pool;
+}
+
+// every thread that uses a tree holds one of these. It takes an index from
+// the pool the first time the thread needs one, and gives it back when the
+// thread exits, so any number of threads can come and go over time as long
+// as at most MAX_THREADS of them are alive at once
+struct ThreadIndexHolder {
+  int index;
+
+  ThreadIndexHolder() {
+    ThreadIndexPool &pool = threadIndexPool();
+    std::lock_guard<std::mutex> guard(pool.lock);
+
+    if (!pool.free.empty()) {
+      this->index = pool.free.back();
+      pool.free.pop_back();
+    } else if (pool.next < MAX_THREADS) {
+      this->index = pool.next++;
+    } else {
+      std::cerr << "More than " << MAX_THREADS
+                << " threads are using a ConcurrentBST at once" << std::endl;
+      std::abort();
+    }
+  }
+
+  ~ThreadIndexHolder() {
+    ThreadIndexPool &pool = threadIndexPool();
+    std::lock_guard<std::mutex> guard(pool.lock);
+    pool.free.push_back(this->index);
+  }
+};
+
+// this function returns a number for the calling thread, between 0 and
+// MAX_THREADS - 1, which is the same every time the thread calls it. No two
+// threads that are alive at the same time get the same number
+int threadIndex() {
+  thread_local ThreadIndexHolder holder;
+  return holder.index;
+}
+
+// this class represents the concurrent binary search tree. It contains
+// functions to search, insert and delete keys, which can all be called from
+// many threads at the same time
+class ConcurrentBST {
+private:
+  struct Node {
+    const int data; // the key never changes, so readers don't need a lock
+    std::atomic<bool> deleted{false}; // marked as deleted (a routing node)
+    bool removed = false; // unlinked from the tree (only read under the lock)
+    std::atomic_flag locked = ATOMIC_FLAG_INIT;
+    std::atomic<Node *> left{nullptr}, right{nullptr};
+
+    Node(int data) : data(data) {}
+
+    // the node's spinlock. Writers hold it for only a few instructions, so
+    // spinning is cheaper than putting the thread to sleep
+    void lock() {
+      while (this->locked.test_and_set(std::memory_order_acquire))
+        std::this_thread::yield();
+    }
+
+    void unlock() { this->locked.clear(std::memory_order_release); }
+  };
+
+  // the information every thread keeps for epoch based reclamation. It is
+  // aligned to a cache line so threads don't slow each other down by writing
+  // to the same line
+  struct alignas(64) ThreadSlot {
+    std::atomic<unsigned long> epoch{0}; // 0 means not in an operation
+    std::vector<std::pair<unsigned long, Node *>> limbo; // unlinked nodes
+  };
+
+  // the head is a sentinel node that is never removed. The real tree hangs off
+  // its left child, so the root can change without any special cases
+  Node head{INT_MAX};
+
+  std::atomic<unsigned long> globalEpoch{1};
+  ThreadSlot slots[MAX_THREADS];
+
+  // this function is called at the start of every operation. It announces
+  // the current epoch for this thread
+  void enter() {
+    this->slots[threadIndex()].epoch.store(this->globalEpoch.load());
+  }
+
+  // this function is called at the end of every operation. It announces that
+  // this thread can't be looking at any node anymore
+  void exit() { this->slots[threadIndex()].epoch.store(0); }
+
+  // this function will take a node that has just been unlinked and put it on
+  // this thread's limbo list. Every so often, it also tries to move the global
+  // epoch forward and free the nodes that are old enough
+  void retire(Node *node) {
+    ThreadSlot &slot = this->slots[threadIndex()];
+    slot.limbo.push_back(std::make_pair(this->globalEpoch.load(), node));
+
+    if (slot.limbo.size() % 64 != 0)
+      return;
+
+    // the global epoch can move forward if every thread that is in an
+    // operation has already seen it
+    unsigned long epoch = this->globalEpoch.load();
+    bool everyoneCaughtUp = true;
+
+    for (int i = 0; i < MAX_THREADS && everyoneCaughtUp; i++) {
+      unsigned long seen = this->slots[i].epoch.load();
+      everyoneCaughtUp = seen == 0 || seen == epoch;
+    }
+
+    if (everyoneCaughtUp)
+      this->globalEpoch.compare_exchange_strong(epoch, epoch + 1);
+
+    // free the nodes that were retired at least two epochs ago
+    epoch = this->globalEpoch.load();
+    size_t kept = 0;
+
+    for (size_t i = 0; i < slot.limbo.size(); i++) {
+      if (slot.limbo[i].first + 2 <= epoch)
+        delete slot.limbo[i].second;
+      else
+        slot.limbo[kept++] = slot.limbo[i];
+    }
+
+    slot.limbo.resize(kept);
+  }
+
+  // this function will take a node and return a pointer to the child link the
+  // key would be found under
+  static std::atomic<Node *> &childFor(Node *node, int key, Node *head) {
+    return (node == head || key < node->data) ? node->left : node->right;
+  }
+
+public:
+  ~ConcurrentBST() {
+    // no other thread can be using the tree anymore, so everything can be
+    // freed: the nodes still in the tree, and the ones in limbo
+    std::vector<Node *> stack;
+    if (this->head.left.load())
+      stack.push_back(this->head.left.load());
+
+    while (!stack.empty()) {
+      Node *node = stack.back();
+      stack.pop_back();
+      if (node->left.load())
+        stack.push_back(node->left.load());
+      if (node->right.load())
+        stack.push_back(node->right.load());
+      delete node;
+    }
+
+    for (ThreadSlot &slot : this->slots)
+      for (std::pair<unsigned long, Node *> &entry : slot.limbo)
+        delete entry.second;
+  }
+
+  // this function will take a key and return true if it is in the tree, else
+  // false. It never takes a lock
+  bool search(int key) {
+    enter();
+
+    Node *node = this->head.left.load(std::memory_order_acquire);
+    while (node && node->data != key)
+      node = (key < node->data ? node->left : node->right)
+                 .load(std::memory_order_acquire);
+
+    bool found = node && !node->deleted.load(std::memory_order_acquire);
+
+    exit();
+    return found;
+  }
+
+  // this function will take a key and insert it into the tree. It returns
+  // false if the key was already in the tree
+  bool insert(int key) {
+    enter();
+
+    while (true) {
+      // find the node with the key, or the node whose empty child the key
+      // would go under, without taking any locks
+      Node *parent = &this->head;
+      Node *node = this->head.left.load();
+
+      while (node && node->data != key) {
+        parent = node;
+        node = (key < node->data ? node->left : node->right).load();
+      }
+
+      if (node) {
+        // the key is already in a node. If that node is marked as deleted,
+        // unmark it. If it has been unlinked since we found it, start over
+        std::lock_guard<Node> guard(*node);
+        if (node->removed)
+          continue;
+
+        bool revived = node->deleted.exchange(false);
+        exit();
+        return revived;
+      }
+
+      // lock the parent, and make sure it is still in the tree and its child
+      // is still empty. If not, another thread got there first, so start over
+      std::lock_guard<Node> guard(*parent);
+      std::atomic<Node *> &link = childFor(parent, key, &this->head);
+
+      if (parent->removed || link.load())
+        continue;
+
+      link.store(new Node(key), std::memory_order_release);
+      exit();
+      return true;
+    }
+  }
+
+  // this function will take a key and delete it from the tree. It returns
+  // false if the key wasn't in the tree
+  bool deleteNode(int key) {
+    enter();
+
+    while (true) {
+      // find the node with the key and its parent without taking any locks
+      Node *parent = &this->head;
+      Node *node = this->head.left.load();
+
+      while (node && node->data != key) {
+        parent = node;
+        node = (key < node->data ? node->left : node->right).load();
+      }
+
+      if (!node) {
+        exit();
+        return false;
+      }
+
+      // lock the parent and then the node, and make sure they are both still
+      // in the tree and still linked together
+      std::lock_guard<Node> parentGuard(*parent);
+      std::lock_guard<Node> nodeGuard(*node);
+      std::atomic<Node *> &link = childFor(parent, key, &this->head);
+
+      if (parent->removed || node->removed || link.load() != node)
+        continue;
+
+      if (node->deleted.load()) {
+        exit();
+        return false; // the key was already deleted
+      }
+
+      Node *left = node->left.load(), *right = node->right.load();
+
+      if (left && right) {
+        // a node with two children just gets marked as deleted
+        node->deleted.store(true, std::memory_order_release);
+      } else {
+        // a node with at most one child is replaced by that child. The node's
+        // own child links are left alone, so a reader that is standing on it
+        // can still continue down into the child
+        link.store(left ? left : right, std::memory_order_release);
+        node->removed = true;
+        retire(node);
+      }
+
+      exit();
+      return true;
+    }
+  }
+};
+
+// main function, which is just driver code to test and benchmark the above
+int main(int argc, char *argv[]) {
+  ConcurrentBST tree; // create a new, empty tree
+
+  int keys[] = {20, 30, 40, 70, 60, 80};
+  for (int key : keys)
+    tree.insert(key);
+
+  tree.deleteNode(20); // a node with one child, which gets unlinked
+  tree.deleteNode(30); // a node with one child, which gets unlinked
+  tree.deleteNode(70); // a node with two children, which gets marked
+
+  std::cout << "Search for 30: " << tree.search(30) << std::endl;
+  std::cout << "Search for 40: " << tree.search(40) << std::endl;
+  std::cout << "Search for 70: " << tree.search(70) << std::endl;
+  tree.insert(70); // unmark the node again
+  std::cout << "Search for 70 after inserting it again: " << tree.search(70)
+            << std::endl;
+
+  // BENCHMARK
+  // both trees start with 1M random keys. Then every thread runs a mix of 90%
+  // searches, 5% inserts and 5% deletes of random keys, and we measure the
+  // total number of operations per second, for 1 thread up to the number of
+  // cores on the machine
+  long opsPerThread = argc > 1 ? std::atol(argv[1]) : 1000000;
+  const int keyRange = 2000000;
+  int maxThreads = std::thread::hardware_concurrency();
+  if (maxThreads < 1)
+    maxThreads = 1;
+  if (maxThreads > MAX_THREADS - 1)
+    maxThreads = MAX_THREADS - 1; // the main thread holds an index too
+
+  ConcurrentBST concurrent;
+  BST *locked = new BST(keyRange / 2);
+  std::mutex globalLock; // the one mutex protecting the regular tree
+
+  std::mt19937 rng(42);
+  for (int i = 0; i < keyRange / 2; i++) {
+    int key = rng() % keyRange;
+    concurrent.insert(key);
+    locked = locked->insert(locked, key);
+  }
+
+  std::cout << "threads\tglobal mutex (Mops/s)\tconcurrent (Mops/s)"
+            << std::endl;
+
+  for (int threads = 1; threads <= maxThreads; threads *= 2) {
+    double results[2];
+
+    for (int which = 0; which < 2; which++) {
+      // every thread counts how many of its searches found the key and adds
+      // that to hits at the end, so the searches can't be optimized away
+      std::atomic<long> hits(0);
+
+      auto worker = [&](int id) {
+        std::mt19937 local(id + 1);
+        long found = 0;
+
+        for (long i = 0; i < opsPerThread; i++) {
+          int key = local() % keyRange;
+          int op = local() % 100;
+
+          if (which == 1) {
+            if (op < 90)
+              found += concurrent.search(key);
+            else if (op < 95)
+              concurrent.insert(key);
+            else
+              concurrent.deleteNode(key);
+          } else {
+            std::lock_guard<std::mutex> guard(globalLock);
+            if (op < 90)
+              found += locked->search(locked, key) != nullptr;
+            else if (op < 95)
+              locked = locked->insert(locked, key);
+            else if (key != locked->data) // never delete the root, so the
+              locked = locked->deleteNode(locked, key); // tree isn't emptied
+          }
+        }
+
+        hits += found;
+      };
+
+      auto begin = std::chrono::steady_clock::now();
+      std::vector<std::thread> pool;
+      for (int t = 0; t < threads; t++)
+        pool.push_back(std::thread(worker, t));
+      for (std::thread &t : pool)
+        t.join();
+      auto finish = std::chrono::steady_clock::now();
+
+      results[which] = threads * opsPerThread /
+                       std::chrono::duration<double>(finish - begin).count() /
+                       1e6;
+    }
+
+    std::cout << threads << "\t" << results[0] << "\t\t\t" << results[1]
+              << std::endl;
+
+    // make sure the last thread count tried is the number of cores
+    if (threads < maxThreads && threads * 2 > maxThreads)
+      threads = maxThreads / 2;
+  }
+
+  return 0;
+}
@@ -0,0 +1,293 @@
+// This document contains an implementation of a multiset (a set that can hold
+// many copies of the same key) as a balanced binary search tree that stores
+// each distinct key once, along with how many copies of it there are. It comes
+// with a benchmark comparing it to the regular binary search tree in
+// binary-search-trees.cpp, which stores every copy as its own node.
+
+// The regular binary search tree inserts a key that is equal to a node's key
+// into that node's left subtree. So if we insert the same key over and over,
+// every copy goes below the last one, and the copies form a chain as long as
+// the number of copies. Every insert then walks the whole chain, so inserting
+// m copies takes O(m^2) time, and deleteNode only removes one copy at a time.
+
+// Instead, every node of this tree stores a count, and inserting a key that is
+// already in the tree just adds to its count. A million copies of a key are
+// then one node, and counting or erasing them is a single search. To keep
+// every operation O(log(n)), where n is the number of DISTINCT keys, the tree
+// is balanced the same way as the AVL tree in avl-trees.cpp.
+
+#include "../../algorithms/binary-tree-traversals/headers/BST.h" // the regular binary search tree, to compare against
+#include <algorithm> // for max
+#include <chrono>    // for timing the benchmark
+#include <cstdlib>   // for atol
+#include <iostream>  // basic input and output
+#include <random>    // for generating random keys
+#include <vector>    // to be able to use vectors
+
+// this function is declared in the BST header file and is used by the BST
+// class
+BST *minValueNode(BST *node) {
+  BST *current = node;
+
+  while (current && current->left)
+    current = current->left;
+
+  return current;
+}
+
+// just like the AVL tree class, the multiset tree class represents both the
+// tree and each of its nodes. Each node stores a distinct key, the number of
+// copies of it, and its height
+class MultisetTree {
+public:
+  int data;
+  long count;     // the number of copies of the key
+  int height = 1; // a new node is a leaf, so its height is 1
+  MultisetTree *left = nullptr, *right = nullptr;
+
+  // constructor for easy creation of a tree (or a tree node) holding the
+  // given number of copies of a key
+  MultisetTree(int data, long count = 1) {
+    this->data = data;
+    this->count = count;
+  }
+
+  // this is a utility function that returns the height of a node, which is 0
+  // if the node is null
+  static int heightOf(MultisetTree *node) { return node ? node->height : 0; }
+
+  // this is a utility function that recalculates the height of a node from the
+  // heights of its children
+  static void updateHeight(MultisetTree *node) {
+    node->height = 1 + std::max(heightOf(node->left), heightOf(node->right));
+  }
+
+  // this is a utility function that returns the balance factor of a node: the
+  // height of its left subtree minus the height of its right subtree
+  static int balanceOf(MultisetTree *node) {
+    return heightOf(node->left) - heightOf(node->right);
+  }
+
+  // these are the same rotations as the AVL tree (see avl-trees.cpp). They
+  // will take a node, rotate the subtree rooted at it to the right (or left)
+  // and return the new root of the subtree
+  static MultisetTree *rotateRight(MultisetTree *y) {
+    MultisetTree *x = y->left;
+    y->left = x->right;
+    x->right = y;
+
+    updateHeight(y);
+    updateHeight(x);
+
+    return x;
+  }
+
+  static MultisetTree *rotateLeft(MultisetTree *x) {
+    MultisetTree *y = x->right;
+    x->right = y->left;
+    y->left = x;
+
+    updateHeight(x);
+    updateHeight(y);
+
+    return y;
+  }
+
+  // this function will take the root of a subtree whose children are both
+  // balanced, fix its balance with one or two rotations (see avl-trees.cpp
+  // for the four cases), and return the new root of the subtree
+  static MultisetTree *rebalance(MultisetTree *root) {
+    updateHeight(root);
+    int balance = balanceOf(root);
+
+    if (balance > 1) {
+      if (balanceOf(root->left) < 0)
+        root->left = rotateLeft(root->left); // left-right case
+      return rotateRight(root);              // left-left case
+    }
+
+    if (balance < -1) {
+      if (balanceOf(root->right) > 0)
+        root->right = rotateRight(root->right); // right-left case
+      return rotateLeft(root);                  // right-right case
+    }
+
+    return root; // the subtree is already balanced
+  }
+
+  // function to conduct an inorder traversal and print out the tree. Every
+  // key is printed once, along with its number of copies
+  void inOrderTraversal(MultisetTree *root) {
+    if (root) {
+      inOrderTraversal(root->left);
+      std::cout << root->data << " (x" << root->count << ")" << std::endl;
+      inOrderTraversal(root->right);
+    }
+  }
+
+  // this function will take a root node and a key. It will search the tree
+  // for the node with the given key, and return that node when it is found.
+  // If the key is not in the tree, this function will return nullptr
+  MultisetTree *search(MultisetTree *root, int key) {
+    while (root && root->data != key)
+      root = root->data < key ? root->right : root->left;
+
+    return root;
+  }
+
+  // this function will take a root node and a key, and return the number of
+  // copies of the key in the tree (0 if it isn't in the tree)
+  long countOf(MultisetTree *root, int key) {
+    MultisetTree *node = search(root, key);
+    return node ? node->count : 0;
+  }
+
+  // this function will take a root node, a key and a number of copies (1 by
+  // default). It will add that many copies of the key to the tree and return
+  // a pointer to the root of the new (rebalanced) tree
+  MultisetTree *insert(MultisetTree *root, int key, long copies = 1) {
+    // the strategy is the same as inserting into an AVL tree, except that if
+    // we find a node with the key, we just add to its count. The shape of the
+    // tree doesn't change then, so there is nothing to rebalance
+
+    if (!root)
+      return new MultisetTree(key, copies);
+
+    if (key == root->data) {
+      root->count += copies;
+      return root;
+    }
+
+    if (key > root->data)
+      root->right = insert(root->right, key, copies);
+    else
+      root->left = insert(root->left, key, copies);
+
+    return rebalance(root);
+  }
+
+  // this function will take a root node, a key and a number of copies. It will
+  // remove that many copies of the key from the tree (or all of them, if
+  // there are fewer) and return the root of the new (rebalanced) tree. The
+  // node is only deleted once its last copy is removed
+  MultisetTree *erase(MultisetTree *root, int key, long copies) {
+    // the strategy is the same as deleting from an AVL tree (see
+    // avl-trees.cpp), except that if the node has more copies than we're
+    // removing, we just subtract from its count
+
+    if (!root)
+      return root;
+
+    if (root->data > key) {
+      root->left = erase(root->left, key, copies);
+    } else if (root->data < key) {
+      root->right = erase(root->right, key, copies);
+    } else {
+      if (root->count > copies) {
+        root->count -= copies;
+        return root;
+      }
+
+      // if the node has at most one child, replace it with that child
+      if (!root->left || !root->right) {
+        MultisetTree *child = root->left ? root->left : root->right;
+        delete root;
+        return child;
+      }
+
+      // if both child nodes exist, move the inorder successor's key AND count
+      // into this node, and remove the successor (with all of its copies)
+      // from the right subtree
+      MultisetTree *successor = root->right;
+      while (successor->left)
+        successor = successor->left;
+
+      root->data = successor->data;
+      root->count = successor->count;
+      root->right = erase(root->right, successor->data, successor->count);
+    }
+
+    return rebalance(root);
+  }
+
+  // this function will take a root node and a key. It will remove one copy of
+  // the key from the tree and return the root of the new tree
+  MultisetTree *deleteNode(MultisetTree *root, int key) {
+    return erase(root, key, 1);
+  }
+};
+
+// main function, which is just driver code to test and benchmark the above
+int main(int argc, char *argv[]) {
+  MultisetTree *tree = new MultisetTree(20); // create a new tree with an
+                                             // initial value of 20
+
+  // insert some nodes, with a lot of copies of 40
+  tree = tree->insert(tree, 30);
+  tree = tree->insert(tree, 20);
+  tree = tree->insert(tree, 40, 1000000);
+  tree = tree->insert(tree, 70);
+
+  std::cout << "Inorder traversal of tree:" << std::endl;
+  tree->inOrderTraversal(tree);
+
+  tree = tree->deleteNode(tree, 20);
+  tree = tree->erase(tree, 40, 999999);
+  std::cout << "After deleting one 20 and 999999 40s:" << std::endl;
+  tree->inOrderTraversal(tree);
+
+  // BENCHMARK
+  // insert n keys into both trees, drawn from only 100 distinct values, then
+  // count the copies of every value, then erase them all. The regular tree
+  // has a chain of copies for every value, so n is kept small by default (it
+  // can be passed as the first argument). The regular tree counts copies with
+  // a range scan, and erases them one deleteNode at a time
+  int n = std::max(argc > 1 ? (int)std::atol(argv[1]) : 20000, 1);
+  const int distinct = 100;
+
+  std::mt19937 rng(42);
+  std::vector<int> keys(n);
+  for (int &key : keys)
+    key = rng() % distinct;
+
+  long bstTotal = 0, multisetTotal = 0;
+
+  auto begin = std::chrono::steady_clock::now();
+  BST *bst = new BST(keys[0]);
+  for (int i = 1; i < n; i++)
+    bst = bst->insert(bst, keys[i]);
+  for (int key = 0; key < distinct; key++) {
+    long copies = 0;
+    bst->scan(bst, key, key, [&copies](int) { copies++; });
+    bstTotal += copies;
+  }
+  for (int key = 0; key < distinct; key++)
+    while (bst && bst->search(bst, key))
+      bst = bst->deleteNode(bst, key);
+  auto middle = std::chrono::steady_clock::now();
+
+  MultisetTree *multiset = new MultisetTree(keys[0]);
+  for (int i = 1; i < n; i++)
+    multiset = multiset->insert(multiset, keys[i]);
+  for (int key = 0; key < distinct; key++)
+    multisetTotal += multiset->countOf(multiset, key);
+  for (int key = 0; multiset && key < distinct; key++)
+    multiset = multiset->erase(multiset, key, multiset->countOf(multiset, key));
+  auto finish = std::chrono::steady_clock::now();
+
+  // both trees must count every key, and end up empty
+  if (bstTotal != n || multisetTotal != n || bst || multiset) {
+    std::cout << "The counts are wrong" << std::endl;
+    return 1;
+  }
+
+  std::cout << n << " keys (" << distinct << " distinct): BST "
+            << std::chrono::duration<double, std::milli>(middle - begin)
+                   .count()
+            << " ms, multiset "
+            << std::chrono::duration<double, std::milli>(finish - middle)
+                   .count()
+            << " ms" << std::endl;
+
+  return 0;
+}
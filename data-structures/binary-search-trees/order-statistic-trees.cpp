@@ -0,0 +1,371 @@
+// This document contains an implementation of an order statistic tree, which
+// is a binary search tree that can also find the k-th smallest key, the rank
+// of a key, and the number of keys in a range, all in O(log(n)) time. It comes
+// with a benchmark comparing it to walking the regular binary search tree in
+// binary-search-trees.cpp in order.
+
+// Definition of an order statistic tree (Wikipedia): an order statistic tree
+// is a variant of the binary search tree (or more generally, a B-tree) that
+// supports two additional operations beyond insertion, lookup and deletion:
+//    - Select(i): find the i-th smallest element stored in the tree
+//    - Rank(x): find the rank of element x in the tree, i.e. its index in the
+//    sorted list of elements of the tree
+
+// With the regular binary search tree, the only way to find the k-th smallest
+// key is to walk the tree in order and count, which takes O(n) time. The trick
+// is to store in every node the size of its subtree (the number of nodes in
+// it, including itself). Then, at any node, we know that exactly
+// size(left) keys come before it in its subtree, so we know whether the k-th
+// smallest key is in the left subtree, is the node itself, or is in the right
+// subtree, and we only go down one path.
+
+// The sizes only help if the tree is balanced, since the time is still O(h),
+// so this tree is built on top of the AVL tree in avl-trees.cpp: every node
+// stores both its height and its size, and both are recalculated whenever a
+// node's children change, including in the rotations.
+
+// Just like the regular binary search tree, keys that are equal to a node's
+// key are inserted into its left subtree, so the tree can hold duplicates.
+
+#include "../../algorithms/binary-tree-traversals/headers/BST.h" // the regular binary search tree, to compare against
+#include <algorithm> // for max
+#include <chrono>    // for timing the benchmark
+#include <cstdlib>   // for atol
+#include <iostream>  // basic input and output
+#include <random>    // for generating random keys
+#include <vector>    // to be able to use vectors
+
+// this function is declared in the BST header file and is used by the BST
+// class
+BST *minValueNode(BST *node) {
+  BST *current = node;
+
+  while (current && current->left)
+    current = current->left;
+
+  return current;
+}
+
+// just like the AVL tree class, the order statistic tree class represents both
+// the tree and each of its nodes. Each node stores its key, its height and the
+// size of its subtree
+class OrderStatisticTree {
+public:
+  int data;
+  int height = 1; // a new node is a leaf, so its height is 1
+  int size = 1;   // and its subtree is just itself
+  OrderStatisticTree *left = nullptr, *right = nullptr;
+
+  // constructor for easy creation of a tree (or a tree node)
+  OrderStatisticTree(int data) { this->data = data; }
+
+  // this is a utility function that returns the height of a node, which is 0
+  // if the node is null
+  static int heightOf(OrderStatisticTree *node) {
+    return node ? node->height : 0;
+  }
+
+  // this is a utility function that returns the size of a node's subtree,
+  // which is 0 if the node is null
+  static int sizeOf(OrderStatisticTree *node) { return node ? node->size : 0; }
+
+  // this is a utility function that recalculates the height and the size of a
+  // node from its children. It has to be called every time a node's children
+  // change
+  static void update(OrderStatisticTree *node) {
+    node->height = 1 + std::max(heightOf(node->left), heightOf(node->right));
+    node->size = 1 + sizeOf(node->left) + sizeOf(node->right);
+  }
+
+  // this is a utility function that returns the balance factor of a node: the
+  // height of its left subtree minus the height of its right subtree
+  static int balanceOf(OrderStatisticTree *node) {
+    return heightOf(node->left) - heightOf(node->right);
+  }
+
+  // ROTATIONS
+  // these are the same as the AVL tree rotations (see avl-trees.cpp). A
+  // rotation only changes the children of the two nodes it moves, so only
+  // their heights and sizes have to be updated, lowest node first
+
+  // this function will take a node y, rotate the subtree rooted at y to the
+  // right and return the new root of the subtree
+  static OrderStatisticTree *rotateRight(OrderStatisticTree *y) {
+    OrderStatisticTree *x = y->left;
+    y->left = x->right;
+    x->right = y;
+
+    update(y);
+    update(x);
+
+    return x;
+  }
+
+  // this function will take a node x, rotate the subtree rooted at x to the
+  // left and return the new root of the subtree
+  static OrderStatisticTree *rotateLeft(OrderStatisticTree *x) {
+    OrderStatisticTree *y = x->right;
+    x->right = y->left;
+    y->left = x;
+
+    update(x);
+    update(y);
+
+    return y;
+  }
+
+  // this function will take the root of a subtree whose children are both
+  // balanced, fix its balance with one or two rotations (see avl-trees.cpp
+  // for the four cases), and return the new root of the subtree
+  static OrderStatisticTree *rebalance(OrderStatisticTree *root) {
+    update(root);
+    int balance = balanceOf(root);
+
+    if (balance > 1) {
+      if (balanceOf(root->left) < 0)
+        root->left = rotateLeft(root->left); // left-right case
+      return rotateRight(root);              // left-left case
+    }
+
+    if (balance < -1) {
+      if (balanceOf(root->right) > 0)
+        root->right = rotateRight(root->right); // right-left case
+      return rotateLeft(root);                  // right-right case
+    }
+
+    return root; // the subtree is already balanced
+  }
+
+  // function to conduct an inorder traversal and print out the tree
+  void inOrderTraversal(OrderStatisticTree *root) {
+    if (root) {
+      inOrderTraversal(root->left);
+      std::cout << root->data << std::endl;
+      inOrderTraversal(root->right);
+    }
+  }
+
+  // this function will take a root node and a key. It will search the tree
+  // for the first occurence of a node with a given key, and return that node
+  // when it is found. If a node with that key is not found, this function
+  // will return nullptr
+  OrderStatisticTree *search(OrderStatisticTree *root, int key) {
+    while (root && root->data != key)
+      root = root->data < key ? root->right : root->left;
+
+    return root;
+  }
+
+  // this function will take a root node and a key. It will insert a node
+  // with the given key into the tree and return a pointer to the root of the
+  // new (rebalanced) tree. Every node on the path gets one bigger, which
+  // rebalance takes care of on the way back up
+  OrderStatisticTree *insert(OrderStatisticTree *root, int key) {
+    if (!root)
+      return new OrderStatisticTree(key);
+
+    if (key > root->data)
+      root->right = insert(root->right, key);
+    else
+      root->left = insert(root->left, key);
+
+    return rebalance(root);
+  }
+
+  // this function will take a root node and a key. It will delete the first
+  // occurence of a node in the tree and return the root of the new
+  // (rebalanced) tree
+  OrderStatisticTree *deleteNode(OrderStatisticTree *root, int key) {
+    if (!root)
+      return root;
+
+    if (root->data > key) {
+      root->left = deleteNode(root->left, key);
+    } else if (root->data < key) {
+      root->right = deleteNode(root->right, key);
+    } else {
+      // if the node has at most one child, replace it with that child
+      if (!root->left || !root->right) {
+        OrderStatisticTree *child = root->left ? root->left : root->right;
+        delete root;
+        return child;
+      }
+
+      // if both child nodes exist, copy the inorder successor's data into
+      // this node and delete the inorder successor from the right subtree
+      OrderStatisticTree *successor = root->right;
+      while (successor->left)
+        successor = successor->left;
+
+      root->data = successor->data;
+      root->right = deleteNode(root->right, successor->data);
+    }
+
+    return rebalance(root);
+  }
+
+  // this function will take a root node and a key, and return the rank of the
+  // key: the number of keys in the tree that are less than it. The key
+  // doesn't have to be in the tree
+  int rank(OrderStatisticTree *root, int key) {
+    // the strategy is to walk down towards the key. Every time we go right,
+    // the node and its whole left subtree are less than the key, so we count
+    // them
+    int count = 0;
+
+    while (root) {
+      if (root->data < key) {
+        count += sizeOf(root->left) + 1;
+        root = root->right;
+      } else {
+        root = root->left;
+      }
+    }
+
+    return count;
+  }
+
+  // this function will take a root node and a number k, and return the node
+  // with the k-th smallest key (k = 1 is the smallest). If k is less than 1 or
+  // more than the number of keys, this function will return nullptr
+  OrderStatisticTree *select(OrderStatisticTree *root, int k) {
+    // the strategy is to compare k with the number of keys in the left
+    // subtree. If it's at most that, the key is in the left subtree. If it's
+    // one more, it's the node itself. Else, it's in the right subtree, where
+    // we look for the (k - size(left) - 1)-th smallest key
+    while (root) {
+      int leftSize = sizeOf(root->left);
+
+      if (k <= leftSize) {
+        root = root->left;
+      } else if (k == leftSize + 1) {
+        return root;
+      } else {
+        k -= leftSize + 1;
+        root = root->right;
+      }
+    }
+
+    return nullptr;
+  }
+
+  // this function will take a root node and two keys lo and hi, and return
+  // the number of keys in the tree between lo and hi (both included)
+  int countRange(OrderStatisticTree *root, int lo, int hi) {
+    // the number of keys that are at most hi, minus the number of keys that
+    // are less than lo. To count the keys that are at most hi, we walk down
+    // just like rank, but also count the nodes equal to hi
+    if (lo > hi)
+      return 0;
+
+    int atMostHi = 0;
+    for (OrderStatisticTree *node = root; node;) {
+      if (node->data <= hi) {
+        atMostHi += sizeOf(node->left) + 1;
+        node = node->right;
+      } else {
+        node = node->left;
+      }
+    }
+
+    return atMostHi - rank(root, lo);
+  }
+};
+
+// this is a utility function that will take the root of a regular binary
+// search tree and a number k, and return the k-th smallest key by walking the
+// tree in order, which is the only way to do it without subtree sizes. It
+// uses a stack instead of recursion, since the tree might be very tall
+int selectByWalking(BST *root, int k) {
+  std::vector<BST *> stack;
+
+  while (root || !stack.empty()) {
+    while (root) {
+      stack.push_back(root);
+      root = root->left;
+    }
+
+    root = stack.back();
+    stack.pop_back();
+    if (--k == 0)
+      return root->data;
+    root = root->right;
+  }
+
+  return -1;
+}
+
+// main function, which is just driver code to test and benchmark the above
+int main(int argc, char *argv[]) {
+  OrderStatisticTree *tree =
+      new OrderStatisticTree(20); // create a new tree with an initial value
+                                  // of 20
+
+  // insert some nodes
+  int keys[] = {30, 20, 40, 70, 60, 80};
+  for (int key : keys)
+    tree = tree->insert(tree, key);
+
+  std::cout << "Inorder traversal of tree:" << std::endl;
+  tree->inOrderTraversal(tree);
+
+  std::cout << "3rd smallest key: " << tree->select(tree, 3)->data << std::endl;
+  std::cout << "Rank of 60: " << tree->rank(tree, 60) << std::endl;
+  std::cout << "Keys between 25 and 70: " << tree->countRange(tree, 25, 70)
+            << std::endl;
+
+  tree = tree->deleteNode(tree, 20);
+  std::cout << "After deleting 20, 3rd smallest key: "
+            << tree->select(tree, 3)->data << std::endl;
+
+  // BENCHMARK
+  // insert n random keys into both trees, then find the 1st, 2nd, ... 99th
+  // percentiles (the 1% * n-th smallest key, and so on). The regular tree has
+  // to walk the tree in order for each one. n can be passed as the first
+  // argument
+  int n = std::max(argc > 1 ? (int)std::atol(argv[1]) : 1000000, 1);
+
+  std::mt19937 rng(42);
+  std::vector<int> random(n);
+  for (int &key : random)
+    key = rng();
+
+  BST *bst = new BST(random[0]);
+  OrderStatisticTree *ost = new OrderStatisticTree(random[0]);
+  for (int i = 1; i < n; i++) {
+    bst = bst->insert(bst, random[i]);
+    ost = ost->insert(ost, random[i]);
+  }
+
+  long long walkSum = 0, selectSum = 0;
+
+  // the p-th percentile is the key at position n * p / 100 (at least 1, since
+  // positions start at 1)
+  std::vector<int> positions;
+  for (int p = 1; p < 100; p++)
+    positions.push_back(std::max(1LL, (long long)n * p / 100));
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int k : positions)
+    walkSum += selectByWalking(bst, k);
+  auto middle = std::chrono::steady_clock::now();
+  for (int k : positions)
+    selectSum += ost->select(ost, k)->data;
+  auto finish = std::chrono::steady_clock::now();
+
+  // both trees hold the same keys, so they must find the same percentiles
+  if (walkSum != selectSum) {
+    std::cout << "Percentiles differ" << std::endl;
+    return 1;
+  }
+
+  std::cout << "99 percentiles of " << n << " keys: walking "
+            << std::chrono::duration<double, std::milli>(middle - begin)
+                   .count()
+            << " ms, select "
+            << std::chrono::duration<double, std::milli>(finish - middle)
+                   .count()
+            << " ms" << std::endl;
+
+  return 0;
+}
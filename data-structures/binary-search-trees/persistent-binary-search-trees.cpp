@@ -0,0 +1,487 @@
+// This document contains an implementation of a persistent binary search tree,
+// which keeps every old version of the tree readable after it is changed,
+// along with a demo of a writer thread changing the tree while reader threads
+// read consistent snapshots of it.
+
+// Definition of a persistent data structure (Wikipedia): a persistent data
+// structure is a data structure that always preserves the previous version of
+// itself when it is modified. Such data structures are effectively immutable,
+// as their operations do not (visibly) update the structure in-place, but
+// instead always yield a new updated structure.
+
+// Copying the whole tree on every change would take O(n) time and memory. But
+// inserting or deleting a key in a binary search tree only changes the nodes
+// on the path from the root down to that key. So instead, we copy just those
+// nodes (this is called path copying). The copies point at the same subtrees
+// as the originals for everything off the path, so the new version shares all
+// of those nodes with the old one, and each change costs O(h) new nodes, where
+// h is the height of the tree. Nodes are never changed after they are made,
+// which is what makes it safe to share them.
+
+// Since a node can be part of many versions, it can only be freed once no
+// version uses it anymore. So every node has a reference count: the number of
+// parents (in any version) and snapshots pointing at it. When a version is
+// released, its root's count goes down, and any node whose count reaches 0 is
+// freed, which releases its children in turn. Nodes shared with a version that
+// is still alive keep a count above 0, so they stay.
+
+// Readers take a snapshot, which is just a counted reference to the root of
+// the current version. Everything they read through it is immutable, so they
+// never see a half finished change. Writers take turns with a mutex, build the
+// new version off to the side, and then swap the new root in.
+
+// Taking a snapshot never takes a lock either. The tricky part is that a
+// reader has to load the root pointer and add a reference to that root as one
+// step, or else a writer could swap the root out and free it in between. So
+// the current root is published together with a counter of "tickets" in a
+// single atomic word (this is called a split reference count). A reader
+// first adds a ticket to the word, which gives it the root pointer and keeps
+// the root alive, then adds a real reference to the root, and then hands the
+// ticket back. When a writer swaps in a new root, it turns every ticket
+// that wasn't handed back yet into a reference, so the old root stays alive
+// until those readers are done with it.
+
+// A reader can only hand its ticket back to the same version it took it from,
+// so the word also holds a generation number that goes up every time a
+// version is published. And a change that doesn't change anything (like
+// deleting a key that isn't in the tree) isn't published at all, so the same
+// root is never published twice in a row.
+
+// Just like the regular binary search tree, keys that are equal to a node's
+// key are inserted into its left subtree, and the tree isn't balanced.
+
+// compile with g++ -O2 -pthread.
+
+#include <atomic>   // for the reference counts and the root
+#include <chrono>   // for timing the demo
+#include <cstdint>  // for uint64_t and uintptr_t
+#include <cstdlib>  // for atol
+#include <iostream> // basic input and output
+#include <mutex>    // for mutexes
+#include <random>   // for generating random keys
+#include <thread>   // for running threads
+#include <vector>   // to be able to use vectors
+
+// this class represents the persistent binary search tree. Writers call
+// insert and deleteNode, and readers call snapshot to get a version of the
+// tree that won't change while they read it
+class PersistentBST {
+private:
+  // a node of the tree. Once it's made, its key and children never change
+  struct Node {
+    const int data;
+    Node *const left, *const right;
+    std::atomic<int> refs{1}; // whoever makes a node holds its first reference
+
+    Node(int data, Node *left, Node *right)
+        : data(data), left(left), right(right) {}
+  };
+
+  // these are utility functions that take a reference to a node (which may be
+  // null) and give it up. retain returns the node so it can be used inline
+  static Node *retain(Node *node) {
+    if (node)
+      node->refs.fetch_add(1, std::memory_order_relaxed);
+    return node;
+  }
+
+  static void release(Node *node) {
+    // a freed node gives up its references to its children, which might free
+    // them too. This uses a stack instead of recursion, since the tree might
+    // be very tall
+    std::vector<Node *> stack;
+    if (node)
+      stack.push_back(node);
+
+    while (!stack.empty()) {
+      node = stack.back();
+      stack.pop_back();
+
+      if (node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        continue; // someone else still uses this node
+
+      if (node->left)
+        stack.push_back(node->left);
+      if (node->right)
+        stack.push_back(node->right);
+      delete node;
+    }
+  }
+
+  // this function will take the nodes on a path from the root down (path[0]
+  // is the root), the index of the last node on the path, and the new subtree
+  // that should take that last node's place. It copies every node above the
+  // last one, bottom to top, pointing each copy at the new subtree below it
+  // instead of the original, and returns the new root
+  static Node *copyPath(Node **path, int last, Node *replacement) {
+    Node *child = replacement;
+
+    for (int i = last - 1; i >= 0; i--) {
+      Node *node = path[i];
+
+      // the child on the path gets replaced, and the other child is shared
+      // (so it gets one more reference)
+      if (node->left == path[i + 1])
+        child = new Node(node->data, child, retain(node->right));
+      else
+        child = new Node(node->data, retain(node->left), child);
+    }
+
+    return child;
+  }
+
+  // this function will take the root of a version and a key, and return the
+  // root of a new version with the key inserted. The old version is unchanged
+  static Node *insert(Node *root, int key) {
+    // walk down to the empty spot the key goes in, like the regular binary
+    // search tree, remembering the path. The last node on the path gets a
+    // copy with the new node as its child, and then the rest of the path is
+    // copied above it
+    std::vector<Node *> path;
+
+    for (Node *node = root; node;
+         node = key > node->data ? node->right : node->left)
+      path.push_back(node);
+
+    Node *leaf = new Node(key, nullptr, nullptr);
+    if (path.empty())
+      return leaf;
+
+    Node *last = path.back();
+    Node *copy = key > last->data
+                     ? new Node(last->data, retain(last->left), leaf)
+                     : new Node(last->data, leaf, retain(last->right));
+
+    return copyPath(path.data(), path.size() - 1, copy);
+  }
+
+  // this function will take the root of a version and a key, and return the
+  // root of a new version with the first occurence of the key deleted (or a
+  // new reference to the same version if the key isn't in it)
+  static Node *remove(Node *root, int key) {
+    std::vector<Node *> path;
+    Node *node = root;
+
+    while (node && node->data != key) {
+      path.push_back(node);
+      node = node->data < key ? node->right : node->left;
+    }
+
+    if (!node)
+      return retain(root);
+
+    path.push_back(node);
+
+    Node *bottom;
+
+    if (!node->left || !node->right) {
+      // if the node has at most one child, that child takes its place
+      bottom = retain(node->left ? node->left : node->right);
+    } else {
+      // if both children exist, the node is replaced by a copy of its inorder
+      // successor, whose right subtree is a copy of the old right subtree
+      // without the successor. The successor is the leftmost node of the right
+      // subtree, so that copy is just the left spine down to it, with the
+      // successor replaced by its right child
+      std::vector<Node *> spine;
+      Node *successor = node->right;
+      while (successor->left) {
+        spine.push_back(successor);
+        successor = successor->left;
+      }
+
+      Node *right = retain(successor->right);
+      for (int i = spine.size() - 1; i >= 0; i--)
+        right = new Node(spine[i]->data, right, retain(spine[i]->right));
+
+      bottom = new Node(successor->data, retain(node->left), right);
+    }
+
+    // the deleted node is the last node on the path, and bottom takes its
+    // place
+    return copyPath(path.data(), path.size() - 1, bottom);
+  }
+
+  // the current version is published as one 64 bit word:
+  //    1. the low 45 bits are the root pointer shifted right by 3. User space
+  //    pointers fit in 48 bits on x86-64 and ARM64, and nodes are aligned to
+  //    8 bytes, so the low 3 bits of a node's address are always 0
+  //    2. the next 7 bits are the generation, which counts the versions
+  //    published so far (wrapping around at 128)
+  //    3. the high 12 bits count the tickets readers haven't handed back yet.
+  //    A reader only holds a ticket for a few instructions, so this only
+  //    limits how many threads can be in the middle of taking a snapshot at
+  //    the same time (4095)
+  static_assert(sizeof(void *) == 8, "the root word needs 64 bit pointers");
+  static_assert(alignof(Node) >= 8, "the root word needs 8 byte aligned nodes");
+  static constexpr int GENERATION_SHIFT = 45;
+  static constexpr int TICKET_SHIFT = 52;
+  static constexpr uint64_t POINTER_MASK = ((uint64_t)1 << 45) - 1;
+  static constexpr uint64_t GENERATION_MASK = (1 << 7) - 1;
+  static constexpr uint64_t VERSION_MASK = ((uint64_t)1 << TICKET_SHIFT) - 1;
+  static constexpr uint64_t ONE_TICKET = (uint64_t)1 << TICKET_SHIFT;
+
+  static Node *rootOf(uint64_t word) {
+    return (Node *)((word & POINTER_MASK) << 3);
+  }
+
+  std::atomic<uint64_t> current{0}; // the current version and its tickets
+  std::mutex writeLock;             // taken by writers, one at a time
+
+  // this function returns the root of the current version. Only writers
+  // (holding writeLock) call it, so the root can't be released under them
+  Node *root() { return rootOf(this->current.load(std::memory_order_acquire)); }
+
+  // this function will take the root of a new version, make it the current
+  // version, and release the old one (which stays alive for any snapshots
+  // still using it). If the new version is the same as the current one, the
+  // extra reference to it is just released instead
+  void publish(Node *newRoot) {
+    uint64_t word = this->current.load(std::memory_order_relaxed);
+    if (newRoot == rootOf(word)) {
+      release(newRoot);
+      return;
+    }
+
+    // only writers change the pointer and the generation, and they take
+    // turns, so the new generation is one past the current one
+    uint64_t generation = ((word >> GENERATION_SHIFT) + 1) & GENERATION_MASK;
+    uint64_t old = this->current.exchange(
+        ((uint64_t)(uintptr_t)newRoot >> 3) | generation << GENERATION_SHIFT,
+        std::memory_order_acq_rel);
+    Node *oldRoot = rootOf(old);
+
+    // every ticket still on the old word belongs to a reader that is about to
+    // add its own reference to the old root, so it gets a reference now to
+    // keep the root alive until then (the reader gives it back when it sees
+    // the root has changed)
+    if (oldRoot && old >> TICKET_SHIFT)
+      oldRoot->refs.fetch_add(old >> TICKET_SHIFT, std::memory_order_relaxed);
+    release(oldRoot);
+  }
+
+public:
+  // a snapshot is a version of the tree that won't change. It holds a
+  // reference to the root of its version, which is released when the
+  // snapshot is destroyed. Snapshots can be copied (which just adds a
+  // reference) and read from any thread without locking
+  class Snapshot {
+  private:
+    Node *root;
+
+  public:
+    Snapshot(Node *root) : root(root) {}
+    Snapshot(const Snapshot &other) : root(retain(other.root)) {}
+    Snapshot &operator=(const Snapshot &other) {
+      Node *old = this->root;
+      this->root = retain(other.root);
+      release(old);
+      return *this;
+    }
+    ~Snapshot() { release(this->root); }
+
+    // this function will take a key and return true if it is in this version
+    // of the tree, else false
+    bool search(int key) const {
+      Node *node = this->root;
+      while (node && node->data != key)
+        node = node->data < key ? node->right : node->left;
+      return node != nullptr;
+    }
+
+    // this function will call the callback with every key in this version of
+    // the tree, in order. It uses a stack instead of recursion, so a very
+    // tall tree can't overflow the call stack
+    template <typename Callback> void forEach(Callback callback) const {
+      std::vector<Node *> stack;
+      Node *node = this->root;
+
+      while (node || !stack.empty()) {
+        while (node) {
+          stack.push_back(node);
+          node = node->left;
+        }
+
+        node = stack.back();
+        stack.pop_back();
+        callback(node->data);
+        node = node->right;
+      }
+    }
+
+    // function to conduct an inorder traversal and print out this version of
+    // the tree
+    void inOrderTraversal() const {
+      forEach([](int key) { std::cout << key << std::endl; });
+    }
+  };
+
+  ~PersistentBST() { release(root()); }
+
+  // this function returns a snapshot of the current version of the tree. It
+  // never takes a lock, so readers are never held up by writers
+  Snapshot snapshot() {
+    // take a ticket, which keeps the root we get alive, and then add our own
+    // reference to that root
+    uint64_t word =
+        this->current.fetch_add(ONE_TICKET, std::memory_order_acquire);
+    Node *root = retain(rootOf(word));
+
+    // hand the ticket back. If the version is still current (the same root
+    // AND the same generation), the ticket is taken off the word. If a writer
+    // published a new version in the meantime, the writer turned our ticket
+    // into a reference, which we give up instead (the root can't be freed by
+    // that, since we hold our own reference now)
+    uint64_t version = word & VERSION_MASK;
+    word += ONE_TICKET;
+    while ((word & VERSION_MASK) == version) {
+      if (this->current.compare_exchange_weak(word, word - ONE_TICKET,
+                                              std::memory_order_acq_rel))
+        return Snapshot(root);
+    }
+
+    if (root)
+      root->refs.fetch_sub(1, std::memory_order_relaxed);
+    return Snapshot(root);
+  }
+
+  // this is a utility function that returns the number of references to the
+  // root of the current version: one for the tree itself, plus one for every
+  // snapshot of it (0 if the tree is empty). It should only be called while
+  // no other thread is using the tree
+  int rootReferences() {
+    Node *node = root();
+    return node ? node->refs.load() : 0;
+  }
+
+  // this function will take a key and insert it into the tree
+  void insert(int key) {
+    std::lock_guard<std::mutex> guard(this->writeLock);
+    publish(insert(root(), key));
+  }
+
+  // this function will take a key and delete the first occurence of it from
+  // the tree
+  void deleteNode(int key) {
+    std::lock_guard<std::mutex> guard(this->writeLock);
+    publish(remove(root(), key));
+  }
+
+  // this function will take two keys, delete the first occurence of the
+  // first one and insert the second one, as a single change: no snapshot
+  // ever sees the tree with just one of them done
+  void replace(int oldKey, int newKey) {
+    // the version in between is never published, so it is released as soon
+    // as the final version is built (which frees the nodes only it used)
+    std::lock_guard<std::mutex> guard(this->writeLock);
+    Node *between = remove(root(), oldKey);
+    publish(insert(between, newKey));
+    release(between);
+  }
+};
+
+// main function, which is just driver code to test and demo the above
+int main(int argc, char *argv[]) {
+  PersistentBST tree; // create a new, empty tree
+
+  // insert some nodes
+  int keys[] = {20, 30, 20, 40, 70, 60, 80};
+  for (int key : keys)
+    tree.insert(key);
+
+  PersistentBST::Snapshot before = tree.snapshot();
+
+  tree.deleteNode(20);
+  tree.deleteNode(30);
+  tree.insert(50);
+
+  // the snapshot taken before the changes still sees the old version
+  std::cout << "Snapshot taken before the changes:" << std::endl;
+  before.inOrderTraversal();
+  std::cout << "Current version after deleting 20 and 30 and inserting 50:"
+            << std::endl;
+  tree.snapshot().inOrderTraversal();
+
+  // DEMO
+  // the main thread keeps replacing random keys with new random keys (so the
+  // number of keys never changes), while reader threads keep taking snapshots
+  // and checking that every snapshot has exactly n keys. A reader that could
+  // see a half finished change would sometimes count a different number. The
+  // number of changes can be passed as the first argument
+  long changes = argc > 1 ? std::atol(argv[1]) : 200000;
+  const int n = 100000;
+  const int readers = 2;
+
+  PersistentBST shared;
+  std::mt19937 rng(42);
+  std::vector<int> current(n);
+  for (int i = 0; i < n; i++) {
+    current[i] = rng();
+    shared.insert(current[i]);
+  }
+
+  std::atomic<bool> done(false);
+  std::atomic<long> snapshotsRead(0), inconsistent(0);
+
+  auto reader = [&]() {
+    while (!done) {
+      PersistentBST::Snapshot snapshot = shared.snapshot();
+      long count = 0;
+      snapshot.forEach([&count](int) { count++; });
+      if (count != n)
+        inconsistent++;
+      snapshotsRead++;
+    }
+  };
+
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (int i = 0; i < readers; i++)
+    pool.push_back(std::thread(reader));
+
+  for (long i = 0; i < changes; i++) {
+    int slot = rng() % n;
+    int key = rng();
+    shared.replace(current[slot], key);
+    current[slot] = key;
+  }
+
+  done = true;
+  for (std::thread &t : pool)
+    t.join();
+  auto finish = std::chrono::steady_clock::now();
+
+  std::cout << changes << " changes to a tree of " << n << " keys in "
+            << std::chrono::duration<double, std::milli>(finish - begin)
+                   .count()
+            << " ms, while " << readers << " readers scanned "
+            << snapshotsRead << " full snapshots (" << inconsistent
+            << " inconsistent)" << std::endl;
+
+  // writes that don't change anything (deleting a key that isn't there, from
+  // an empty tree and then from a tree with a few keys) aren't published, so
+  // a reader taking snapshots of the same version over and over has to leave
+  // the root with just the tree's own reference once it's done
+  PersistentBST unchanged;
+  done = false;
+  std::thread snapshotter([&]() {
+    while (!done)
+      unchanged.snapshot();
+  });
+
+  for (long i = 0; i < changes; i++) {
+    if (i == changes / 2)
+      for (int key : keys)
+        unchanged.insert(key);
+    unchanged.deleteNode(-1);
+  }
+
+  done = true;
+  snapshotter.join();
+
+  std::cout << "References to the root after " << changes
+            << " writes that changed nothing: " << unchanged.rootReferences()
+            << std::endl;
+
+  return inconsistent != 0 || unchanged.rootReferences() != 1;
+}
@@ -0,0 +1,438 @@
+// This document contains functions to save a binary search tree to a file in
+// a compact format and load it back, along with a benchmark comparing that to
+// rebuilding the tree by inserting every key again.
+
+// A binary search tree lives in memory as nodes scattered around the heap,
+// pointing at each other. Pointers mean nothing once the program exits, so the
+// obvious way to save a tree is to write out its keys, and the obvious way to
+// load it is to insert them all again. But that takes O(n * h) time, and every
+// one of those inserts walks down a tree that is much bigger than the cache.
+
+// Instead, we write the nodes in preorder (a node, then its whole left
+// subtree, then its whole right subtree). In preorder, a node's left child (if
+// it has one) is always the very next node, so we don't need to store where
+// it is, just whether it exists. The right child can be anywhere after that,
+// so we store its index. Every node takes 8 bytes in the file:
+//    - the key (4 bytes)
+//    - the index of the right child (31 bits, 0 if there is none, since the
+//    root is the only node at index 0 and it is never a right child), and one
+//    bit that says whether the node has a left child
+
+// This format can be used in two ways:
+//    1. the file can be mapped into memory (mmap), and searched right where it
+//    is, as a read-only tree. Nothing is copied: opening the file reads it
+//    once from start to end to check that its links make a tree, and after
+//    that the searches only touch the pages they need
+//    2. the regular pointer tree can be rebuilt from it in one pass over the
+//    file. We go through the nodes from last to first, so both children of a
+//    node have already been made when we get to it, and it can just point at
+//    them. This keeps the exact shape of the saved tree, and takes O(n) time
+
+// The file format is:
+//    - a header (magic bytes, the size of a node, and the number of nodes)
+//    - the nodes in preorder
+
+// This uses POSIX functions (open, mmap, madvise), so it works on Linux and
+// macOS but not on Windows.
+
+#include "../../algorithms/binary-tree-traversals/headers/BST.h" // the regular binary search tree to save and load
+#include <algorithm>  // for max
+#include <chrono>     // for timing the benchmark
+#include <cstdint>    // for fixed width integer types
+#include <cstdio>     // for fopen, fwrite and remove
+#include <cstdlib>    // for atol
+#include <cstring>    // for memcmp and memcpy
+#include <fcntl.h>    // for open
+#include <iostream>   // basic input and output
+#include <random>     // for generating random keys
+#include <sys/mman.h> // for mmap, munmap and madvise
+#include <sys/stat.h> // for fstat
+#include <unistd.h>   // for close
+#include <utility>    // for std::pair
+#include <vector>     // to be able to use vectors
+
+// this function is declared in the BST header file and is used by the BST
+// class
+BST *minValueNode(BST *node) {
+  BST *current = node;
+
+  while (current && current->left)
+    current = current->left;
+
+  return current;
+}
+
+const char TREE_MAGIC[8] = {'B', 'S', 'T', 'N', 'O', 'D', 'E', 'S'};
+const uint32_t HAS_LEFT = 1u << 31; // the bit that says there's a left child
+
+// a node of the tree, as it is stored in the file
+struct PackedNode {
+  int32_t data;
+  uint32_t right; // HAS_LEFT, plus the index of the right child (or 0)
+};
+
+// the header at the start of every tree file
+struct TreeFileHeader {
+  char magic[8];     // always TREE_MAGIC, so we can tell it's the right format
+  uint32_t nodeSize; // the size of a node in bytes
+  uint32_t unused;   // padding, so count is aligned
+  uint64_t count;    // the number of nodes in the file
+};
+
+// this function will take a path and the root of a binary search tree, and
+// write the tree to the file at the path in the format described above. It
+// returns true if the file was written, else false
+bool writeTreeFile(const char *path, BST *root) {
+  // the strategy is to walk the tree in preorder with a stack (so a very tall
+  // tree can't overflow the call stack). When we visit a node, we give it the
+  // next index. Its right child is pushed first, so that the whole left
+  // subtree is visited before it. A right child is pushed along with its
+  // parent's index + 1 (0 means it isn't a right child), so that once it gets
+  // its own index, the parent's right field can be pointed at it
+
+  std::vector<PackedNode> nodes;
+  std::vector<std::pair<BST *, uint32_t>> stack;
+  if (root)
+    stack.push_back(std::make_pair(root, 0));
+
+  while (!stack.empty()) {
+    BST *node = stack.back().first;
+    uint32_t parent = stack.back().second;
+    stack.pop_back();
+
+    uint32_t index = nodes.size();
+    if (index >= HAS_LEFT)
+      return false; // too many nodes to fit in 31 bits
+    if (parent)
+      nodes[parent - 1].right |= index;
+
+    nodes.push_back(PackedNode{node->data, node->left ? HAS_LEFT : 0});
+
+    if (node->right)
+      stack.push_back(std::make_pair(node->right, index + 1));
+    if (node->left)
+      stack.push_back(std::make_pair(node->left, 0));
+  }
+
+  FILE *file = std::fopen(path, "wb");
+  if (!file)
+    return false;
+
+  TreeFileHeader header;
+  std::memcpy(header.magic, TREE_MAGIC, sizeof(TREE_MAGIC));
+  header.nodeSize = sizeof(PackedNode);
+  header.unused = 0;
+  header.count = nodes.size();
+
+  bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+            std::fwrite(nodes.data(), sizeof(PackedNode), nodes.size(),
+                        file) == nodes.size();
+
+  return std::fclose(file) == 0 && ok;
+}
+
+// this class represents a tree file that has been mapped into memory. It
+// contains functions to open and close the file, search the tree right in the
+// mapping, and rebuild the regular pointer tree from it
+class MappedBST {
+private:
+  void *mapping = nullptr;           // the start of the mapped file
+  size_t mappingSize = 0;            // the size of the mapped file
+  const PackedNode *nodes = nullptr; // the nodes in the mapping
+  size_t n = 0;                      // the number of nodes
+
+  // this function will take the nodes of a file and their number, and return
+  // true if their links make a tree in preorder, else false. search and toBST
+  // follow the links without checking them, so a corrupt file would make them
+  // read past the end of the mapping (or loop forever) if we didn't reject it
+  // here. Every node except the root must be the child of exactly one node,
+  // and a child always comes after its parent: the left child is the next
+  // node (so it has to exist), and the right child is anywhere after it
+  static bool linksFormTree(const PackedNode *nodes, size_t n) {
+    std::vector<bool> hasParent(n, false);
+
+    for (size_t i = 0; i < n; i++) {
+      size_t right = nodes[i].right & ~HAS_LEFT;
+
+      if (nodes[i].right & HAS_LEFT) {
+        if (i + 1 >= n || hasParent[i + 1])
+          return false;
+        hasParent[i + 1] = true;
+      }
+
+      if (right) {
+        if (right <= i || right >= n || hasParent[right])
+          return false;
+        hasParent[right] = true;
+      }
+    }
+
+    for (size_t i = 1; i < n; i++)
+      if (!hasParent[i])
+        return false;
+
+    return true;
+  }
+
+public:
+  MappedBST() = default;
+  ~MappedBST() { close(); }
+
+  // the mapping belongs to this object, so copying it would unmap it twice
+  MappedBST(const MappedBST &) = delete;
+  MappedBST &operator=(const MappedBST &) = delete;
+
+  // this function will take a path and map the tree file at that path. It
+  // returns true if the file was opened, else false (if the file doesn't
+  // exist, or isn't a tree file)
+  bool open(const char *path) {
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+      return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TreeFileHeader)) {
+      ::close(fd);
+      return false;
+    }
+
+    // map the whole file. The file descriptor isn't needed once it's mapped
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+      return false;
+
+    // check the header matches what we expect. The count is checked against
+    // the file size with a division, so a huge count can't overflow
+    const TreeFileHeader *header = (const TreeFileHeader *)map;
+    size_t body = st.st_size - sizeof(TreeFileHeader);
+    if (std::memcmp(header->magic, TREE_MAGIC, sizeof(TREE_MAGIC)) != 0 ||
+        header->nodeSize != sizeof(PackedNode) ||
+        body % sizeof(PackedNode) != 0 ||
+        header->count != body / sizeof(PackedNode) ||
+        !linksFormTree(
+            (const PackedNode *)((const char *)map + sizeof(TreeFileHeader)),
+            header->count)) {
+      munmap(map, st.st_size);
+      return false;
+    }
+
+    this->mapping = map;
+    this->mappingSize = st.st_size;
+    this->nodes =
+        (const PackedNode *)((const char *)map + sizeof(TreeFileHeader));
+    this->n = header->count;
+
+    // searches jump around the file, so reading ahead is wasted work
+    madvise(this->mapping, this->mappingSize, MADV_RANDOM);
+
+    return true;
+  }
+
+  // this function will unmap the file, if one is mapped
+  void close() {
+    if (this->mapping)
+      munmap(this->mapping, this->mappingSize);
+
+    this->mapping = nullptr;
+    this->nodes = nullptr;
+    this->n = 0;
+  }
+
+  // this function will take a key and return true if it is in the mapped
+  // tree, else false
+  bool search(int key) {
+    // the same as searching the regular binary search tree, except the left
+    // child is the next node and the right child is found by its index
+    size_t i = 0;
+
+    while (i < this->n) {
+      const PackedNode &node = this->nodes[i];
+      if (node.data == key)
+        return true;
+
+      if (node.data < key) {
+        i = node.right & ~HAS_LEFT;
+        if (i == 0)
+          return false;
+      } else {
+        if (!(node.right & HAS_LEFT))
+          return false;
+        i++;
+      }
+    }
+
+    return false;
+  }
+
+  // this function will rebuild the regular pointer tree from the mapped file
+  // and return its root (nullptr if the tree is empty). The new tree has
+  // exactly the same shape as the one that was saved
+  BST *toBST() {
+    // the strategy is to go through the nodes from last to first, so that
+    // both children of a node have been made by the time we make it. Since
+    // we only go through the file once and in order, we tell the operating
+    // system to read ahead
+    if (this->n == 0)
+      return nullptr;
+
+    madvise(this->mapping, this->mappingSize, MADV_SEQUENTIAL);
+
+    std::vector<BST *> made(this->n);
+    for (size_t i = this->n; i-- > 0;) {
+      BST *node = new BST(this->nodes[i].data);
+      uint32_t right = this->nodes[i].right & ~HAS_LEFT;
+
+      if (this->nodes[i].right & HAS_LEFT) {
+        node->left = made[i + 1];
+        node->left->parent = node;
+      }
+      if (right) {
+        node->right = made[right];
+        node->right->parent = node;
+      }
+
+      made[i] = node;
+    }
+
+    madvise(this->mapping, this->mappingSize, MADV_RANDOM);
+
+    return made[0];
+  }
+
+  // this is a utility function that returns the number of nodes in the file
+  size_t size() { return this->n; }
+};
+
+// this is a utility function that will take the root of a binary search tree
+// and return its keys in preorder, so two trees can be checked to have the
+// same shape
+std::vector<int> preorderKeys(BST *root) {
+  std::vector<int> keys;
+  std::vector<BST *> stack;
+  if (root)
+    stack.push_back(root);
+
+  while (!stack.empty()) {
+    BST *node = stack.back();
+    stack.pop_back();
+    keys.push_back(node->data);
+    if (node->right)
+      stack.push_back(node->right);
+    if (node->left)
+      stack.push_back(node->left);
+  }
+
+  return keys;
+}
+
+// main function, which is just driver code to test and benchmark the above.
+// The number of keys can be passed as the first argument, and the path of the
+// file to write as the second argument
+int main(int argc, char *argv[]) {
+  int n = std::max(argc > 1 ? (int)std::atol(argv[1]) : 1000000, 1);
+  const char *path = argc > 2 ? argv[2] : "/tmp/bst-nodes.bin";
+
+  // build a tree from random keys
+  std::mt19937 rng(42);
+  std::vector<int> original(n);
+  for (int &key : original)
+    key = rng() % n;
+
+  BST *tree = new BST(original[0]);
+  for (int i = 1; i < n; i++)
+    tree = tree->insert(tree, original[i]);
+
+  // save it
+  auto begin = std::chrono::steady_clock::now();
+  if (!writeTreeFile(path, tree)) {
+    std::cout << "Could not write " << path << std::endl;
+    return 1;
+  }
+  auto written = std::chrono::steady_clock::now();
+
+  // the old way to restart: insert every key again, in the order they were
+  // first inserted (so the new tree has the same shape)
+  auto reinsertBegin = std::chrono::steady_clock::now();
+  BST *reinserted = new BST(original[0]);
+  for (int i = 1; i < n; i++)
+    reinserted = reinserted->insert(reinserted, original[i]);
+  auto reinsertEnd = std::chrono::steady_clock::now();
+
+  // the new ways: map the file, and rebuild the pointer tree from it
+  MappedBST file;
+  auto openBegin = std::chrono::steady_clock::now();
+  if (!file.open(path)) {
+    std::cout << "Could not open " << path << std::endl;
+    return 1;
+  }
+  auto opened = std::chrono::steady_clock::now();
+  BST *rebuilt = file.toBST();
+  auto rebuiltEnd = std::chrono::steady_clock::now();
+
+  // the rebuilt tree must have exactly the same keys in the same places
+  if (preorderKeys(rebuilt) != preorderKeys(tree) ||
+      preorderKeys(reinserted) != preorderKeys(tree)) {
+    std::cout << "The rebuilt tree is different" << std::endl;
+    return 1;
+  }
+
+  std::cout << n << " nodes, " << file.size() * sizeof(PackedNode)
+            << " bytes on disk" << std::endl;
+  std::cout << "write: "
+            << std::chrono::duration<double, std::milli>(written - begin)
+                   .count()
+            << " ms" << std::endl;
+  std::cout << "reinsert every key: "
+            << std::chrono::duration<double, std::milli>(reinsertEnd -
+                                                         reinsertBegin)
+                   .count()
+            << " ms" << std::endl;
+  std::cout << "map the file: "
+            << std::chrono::duration<double, std::milli>(opened - openBegin)
+                   .count()
+            << " ms" << std::endl;
+  std::cout << "rebuild from the file: "
+            << std::chrono::duration<double, std::milli>(rebuiltEnd - opened)
+                   .count()
+            << " ms" << std::endl;
+
+  // search for random keys in the pointer tree and in the mapped file, and
+  // make sure they agree
+  const int numQueries = 1000000;
+  std::vector<int> queries(numQueries);
+  for (int &q : queries)
+    q = rng() % (2 * n);
+
+  long pointerFound = 0, mappedFound = 0;
+
+  begin = std::chrono::steady_clock::now();
+  for (int q : queries)
+    pointerFound += tree->search(tree, q) != nullptr;
+  auto middle = std::chrono::steady_clock::now();
+  for (int q : queries)
+    mappedFound += file.search(q);
+  auto finish = std::chrono::steady_clock::now();
+
+  if (pointerFound != mappedFound) {
+    std::cout << "Results differ from the pointer tree" << std::endl;
+    return 1;
+  }
+
+  std::cout << "search: pointer tree "
+            << std::chrono::duration<double, std::nano>(middle - begin)
+                       .count() /
+                   numQueries
+            << " ns, mapped file "
+            << std::chrono::duration<double, std::nano>(finish - middle)
+                       .count() /
+                   numQueries
+            << " ns" << std::endl;
+
+  file.close();
+  std::remove(path); // clean up the file we wrote
+
+  return 0;
+}
@@ -0,0 +1,383 @@
+// This document contains an implementation of a splay tree, which is a self
+// adjusting binary search tree that moves every key it accesses up to the
+// root, along with a benchmark comparing it to the regular binary search tree
+// in binary-search-trees.cpp (both built by random inserts, and perfectly
+// balanced) when a few keys are searched for much more often than the rest.
+
+// Definition of a splay tree (Wikipedia): a splay tree is a binary search tree
+// with the additional property that recently accessed elements are quick to
+// access again. Like self-balancing binary search trees, a splay tree performs
+// basic operations such as insertion, look-up and removal in O(log n)
+// amortized time. For random access patterns drawn from a non-uniform random
+// distribution, their amortized time can be faster than logarithmic,
+// proportional to the entropy of the access pattern.
+
+// In a lot of real workloads, most searches are for a small set of "hot" keys.
+// In a regular binary search tree, a hot key deep in the tree costs as much
+// every time it's searched for. A splay tree moves every key it finds (or the
+// last node it looked at, if the key isn't there) up to the root with
+// rotations, so hot keys stay near the top and are found after just a few
+// steps. Since it adapts on every access, it also follows the hot set when it
+// drifts to different keys over time.
+
+// This tree supports two ways (policies) of moving a node to the root:
+//    1. MOVE_TO_ROOT: rotate the node up past its parent, one rotation at a
+//    time, until it is the root. This is the simplest policy, but a tree can
+//    stay unbalanced under it, so a long run of accesses can take O(n) each
+//    2. SPLAY: rotate the node up two levels at a time, with the zig-zig and
+//    zig-zag steps (see splay below). This also roughly halves the depth of
+//    every node on the path, which is what gives the O(log n) amortized bound
+
+// Just like the regular binary search tree, keys that are equal to a node's
+// key are inserted into its left subtree.
+
+// The benchmark sizes can be changed by passing the number of keys and the
+// number of searches as the first and second arguments.
+
+#include "../../algorithms/binary-tree-traversals/headers/BST.h" // the regular binary search tree, to compare against
+#include <algorithm> // for shuffle, sort, upper_bound, min and max
+#include <chrono>    // for timing the benchmark
+#include <cmath>     // for pow
+#include <cstdlib>   // for atol
+#include <iostream>  // basic input and output
+#include <random>    // for generating random keys
+#include <vector>    // to be able to use vectors
+
+// this function is declared in the BST header file and is used by the BST
+// class
+BST *minValueNode(BST *node) {
+  BST *current = node;
+
+  while (current && current->left)
+    current = current->left;
+
+  return current;
+}
+
+// the ways a splay tree can move an accessed node to the root
+enum AccessPolicy { SPLAY, MOVE_TO_ROOT };
+
+// this class represents the splay tree. It contains functions to search,
+// insert and delete keys, and print the tree using an inorder traversal.
+// Unlike the regular binary search tree, search changes the shape of the tree
+class SplayTree {
+private:
+  struct Node {
+    int data;
+    Node *left = nullptr, *right = nullptr;
+
+    Node(int data) { this->data = data; }
+  };
+
+  Node *root = nullptr;
+  AccessPolicy policy;
+
+  // the path from the top of the tree down to the last node visited: links[i]
+  // is the link pointing at the node at depth i, and left[i] is true if the
+  // path goes left from it. They are kept between calls so that they only
+  // allocate while the tree is getting deeper than ever before
+  std::vector<Node **> links;
+  std::vector<char> left;
+
+  // this function will take a link pointing at a node, and rotate that node's
+  // left child (if fromLeft is true) or right child up into its place
+  static void rotate(Node **link, bool fromLeft) {
+    Node *parent = *link;
+
+    if (fromLeft) {
+      Node *child = parent->left;
+      parent->left = child->right;
+      child->right = parent;
+      *link = child;
+    } else {
+      Node *child = parent->right;
+      parent->right = child->left;
+      child->left = parent;
+      *link = child;
+    }
+  }
+
+  // this function will take a link pointing at the top of a subtree and a
+  // key. It will walk down the subtree looking for the key (to the right if
+  // the key is greater than the node's key, else to the left) and record the
+  // path in links and left. It stops at a node with the key, or at the last
+  // node before a null child, and returns its depth (-1 if the subtree is
+  // empty). If stopAtKey is false, it only stops at a null child (which is
+  // where insert puts a new node)
+  int descend(Node **top, int key, bool stopAtKey) {
+    this->links.clear();
+    this->left.clear();
+
+    Node **link = top;
+    while (*link) {
+      Node *node = *link;
+      this->links.push_back(link);
+      if (stopAtKey && node->data == key)
+        break;
+
+      bool goLeft = !(key > node->data);
+      this->left.push_back(goLeft);
+      link = goLeft ? &node->left : &node->right;
+    }
+
+    return (int)this->links.size() - 1;
+  }
+
+  // this function will take the depth of the node at the end of the recorded
+  // path, and move that node to the top of the path with rotations
+  void splay(int depth) {
+    // with the MOVE_TO_ROOT policy (or when the node is just below the top),
+    // rotate the node up one level. Otherwise, look at the node x, its parent
+    // p and its grandparent g:
+    //    1. zig-zig: x and p are both left children (or both right children).
+    //    Rotate p up past g first, then x up past p
+    //    2. zig-zag: one is a left child and the other is a right child. Rotate
+    //    x up past p, then up past g
+    // Rotations only change the links at and below the top of the path, so
+    // the recorded links above the node stay valid the whole time
+    while (depth > 0) {
+      if (this->policy == MOVE_TO_ROOT || depth == 1) {
+        rotate(this->links[depth - 1], this->left[depth - 1]);
+        depth -= 1;
+      } else if (this->left[depth - 1] == this->left[depth - 2]) {
+        rotate(this->links[depth - 2], this->left[depth - 2]); // zig-zig
+        rotate(this->links[depth - 2], this->left[depth - 1]);
+        depth -= 2;
+      } else {
+        rotate(this->links[depth - 1], this->left[depth - 1]); // zig-zag
+        rotate(this->links[depth - 2], this->left[depth - 2]);
+        depth -= 2;
+      }
+    }
+  }
+
+public:
+  // constructor that creates an empty tree with the given access policy
+  SplayTree(AccessPolicy policy = SPLAY) { this->policy = policy; }
+
+  ~SplayTree() {
+    // delete every node, using a stack instead of recursion since the tree
+    // might be very tall
+    std::vector<Node *> stack;
+    if (this->root)
+      stack.push_back(this->root);
+
+    while (!stack.empty()) {
+      Node *node = stack.back();
+      stack.pop_back();
+      if (node->left)
+        stack.push_back(node->left);
+      if (node->right)
+        stack.push_back(node->right);
+      delete node;
+    }
+  }
+
+  // this function will take a key and return true if a node with that key is
+  // in the tree, else false. The node it finds (or the last node it looked
+  // at, if the key isn't in the tree) is moved to the root
+  bool search(int key) {
+    int depth = descend(&this->root, key, true);
+    if (depth < 0)
+      return false;
+
+    splay(depth);
+    return this->root->data == key;
+  }
+
+  // this function will take a key and insert a node with that key into the
+  // tree. The new node is moved to the root
+  void insert(int key) {
+    int depth = descend(&this->root, key, false);
+
+    Node *node = new Node(key);
+    if (depth < 0) {
+      this->root = node;
+      return;
+    }
+
+    // hang the new node under the last node on the path, and add it to the
+    // path so it can be moved up
+    Node *parent = *this->links[depth];
+    Node **link = this->left[depth] ? &parent->left : &parent->right;
+    *link = node;
+    this->links.push_back(link);
+
+    splay(depth + 1);
+  }
+
+  // this function will take a key and delete the first occurence of a node
+  // with that key from the tree
+  void deleteNode(int key) {
+    // the strategy is to move the node to the root (like search). Then its
+    // left and right subtrees have to be joined: we move the largest node of
+    // the left subtree to the top of the left subtree, which leaves it with no
+    // right child, so the right subtree can just hang there
+    if (!search(key))
+      return;
+
+    Node *old = this->root;
+    Node *leftTree = old->left;
+
+    if (leftTree) {
+      // record the path down the right side of the left subtree to its
+      // largest node, and move that node up
+      this->links.clear();
+      this->left.clear();
+      Node **link = &leftTree;
+      this->links.push_back(link);
+      while ((*link)->right) {
+        this->left.push_back(false);
+        link = &(*link)->right;
+        this->links.push_back(link);
+      }
+
+      splay(this->links.size() - 1);
+      leftTree->right = old->right;
+      this->root = leftTree;
+    } else {
+      this->root = old->right;
+    }
+
+    delete old;
+  }
+
+  // function to conduct an inorder traversal and print out the tree. It uses
+  // a stack instead of recursion so a very tall tree can't overflow the call
+  // stack
+  void inOrderTraversal() {
+    std::vector<Node *> stack;
+    Node *current = this->root;
+
+    while (current || !stack.empty()) {
+      while (current) {
+        stack.push_back(current);
+        current = current->left;
+      }
+
+      current = stack.back();
+      stack.pop_back();
+      std::cout << current->data << std::endl;
+      current = current->right;
+    }
+  }
+
+  // this is a utility function that returns the key at the root
+  int rootKey() { return this->root->data; }
+};
+
+// main function, which is just driver code to test and benchmark the above
+int main(int argc, char *argv[]) {
+  SplayTree tree; // create a new, empty tree
+
+  // insert some nodes
+  int keys[] = {20, 30, 20, 40, 70, 60, 80};
+  for (int key : keys)
+    tree.insert(key);
+
+  std::cout << "Inorder traversal of tree:" << std::endl;
+  tree.inOrderTraversal();
+
+  tree.search(40);
+  std::cout << "Root after searching for 40: " << tree.rootKey() << std::endl;
+
+  tree.deleteNode(20);
+  tree.deleteNode(30);
+  std::cout << "After deleting 20 and 30:" << std::endl;
+  tree.inOrderTraversal();
+
+  // BENCHMARK
+  // n distinct keys go into every tree (in random order). Then we search with
+  // a Zipfian distribution: the i-th hottest key is searched for with
+  // probability proportional to 1 / i^s, so a few keys get most of the
+  // searches. The bigger the skew s is, the fewer keys get most of them. Every
+  // phase, the hot set drifts: the keys are ranked by a different random order
+  const int phases = 4;
+  int n = std::max(argc > 1 ? (int)std::atol(argv[1]) : 1000000, 1);
+  long numSearches =
+      std::max(argc > 2 ? std::atol(argv[2]) : 2000000, (long)phases);
+  double skews[] = {0.99, 1.3};
+
+  std::mt19937 rng(42);
+  std::vector<int> random(n);
+  for (int i = 0; i < n; i++)
+    random[i] = i;
+  std::shuffle(random.begin(), random.end(), rng);
+
+  // build the trees: a regular tree from random inserts, a perfectly
+  // balanced regular tree, and a splay tree with each policy
+  BST *plain = new BST(random[0]);
+  for (int i = 1; i < n; i++)
+    plain = plain->insert(plain, random[i]);
+
+  std::vector<int> sorted = random;
+  std::sort(sorted.begin(), sorted.end());
+  BST *balanced = BST::buildFromSorted(sorted.data(), n);
+
+  SplayTree splay(SPLAY), moveToRoot(MOVE_TO_ROOT);
+  for (int key : random) {
+    splay.insert(key);
+    moveToRoot.insert(key);
+  }
+
+  std::cout << "ns per search:" << std::endl;
+  std::cout << "skew	BST (random inserts)	BST (balanced)	splay tree	"
+               "move to root"
+            << std::endl;
+
+  for (double skew : skews) {
+    // the cumulative Zipfian distribution, so that a random number between 0
+    // and the total can be turned into a rank with a binary search
+    std::vector<double> cdf(n);
+    double total = 0;
+    for (int i = 0; i < n; i++)
+      cdf[i] = total += 1.0 / std::pow(i + 1, skew);
+
+    std::uniform_real_distribution<double> uniform(0, total);
+    std::vector<int> searches(numSearches);
+    std::vector<int> ranking = random;
+
+    for (long i = 0; i < numSearches; i++) {
+      if (i % (numSearches / phases) == 0)
+        std::shuffle(ranking.begin(), ranking.end(), rng); // the hot set drifts
+
+      int rank = std::upper_bound(cdf.begin(), cdf.end(), uniform(rng)) -
+                 cdf.begin();
+      searches[i] = ranking[std::min(rank, n - 1)];
+    }
+
+    std::cout << skew;
+
+    for (int t = 0; t < 4; t++) {
+      long found = 0;
+
+      auto begin = std::chrono::steady_clock::now();
+      for (int key : searches) {
+        if (t == 0)
+          found += plain->search(plain, key) != nullptr;
+        else if (t == 1)
+          found += balanced->search(balanced, key) != nullptr;
+        else if (t == 2)
+          found += splay.search(key);
+        else
+          found += moveToRoot.search(key);
+      }
+      auto finish = std::chrono::steady_clock::now();
+
+      // every search is for a key in the tree
+      if (found != numSearches) {
+        std::cout << std::endl << "Some keys were missed" << std::endl;
+        return 1;
+      }
+
+      std::cout << (t == 1 ? "\t\t\t" : "\t")
+                << std::chrono::duration<double, std::nano>(finish - begin)
+                           .count() /
+                       numSearches;
+    }
+
+    std::cout << std::endl;
+  }
+
+  return 0;
+}